@@ -20,6 +20,7 @@
 #include<iostream>
 
 int tetris();
+int tetrisReplay();
 int doodle_jump();
 int arkanoid();
 int snake();
@@ -35,6 +36,8 @@ int tron();
 int chess();
 int volleyball() {/* TODO add box2D*/ return 0; }
 int asteroids();
+int benchmarks();
+int asteroidsStress();
 
 
 using namespace std;
@@ -60,6 +63,9 @@ int main()
         cout << "Chess\n";
         cout << "Volleyball\n";
         cout << "astEroids\n";
+        cout << "benchmarKs (headless)\n";
+        cout << "asteroids stress (Headless)\n";
+        cout << "tetris rePlay (headless)\n";
 
 
 
@@ -130,6 +136,18 @@ int main()
             case 'E':
                 asteroids();
                 break;
+            case 'k':
+            case 'K':
+                benchmarks();
+                break;
+            case 'h':
+            case 'H':
+                asteroidsStress();
+                break;
+            case 'p':
+            case 'P':
+                tetrisReplay();
+                break;
         }
 
     }
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "ArkanoidCollision.h"
+
+namespace Arkanoid {
+
+    // Any number of balls, stored as one array per field and stepped together.
+    // Each axis step first moves every ball, then finds every ball/block hit
+    // against the blocks alive at the start of the step, then kills the hit
+    // blocks. So when two balls hit the same block in the same tick both
+    // bounce and the block dies once, whatever order the balls are stored in.
+    // A single ball moves exactly as updatePhysics moves it.
+    //
+    // updateSwept() is the same idea on the swept solver, with the paddle:
+    // each ball sweeps against the blocks alive at the start of the tick,
+    // less those it has hit itself, and the hits are applied after all balls
+    // have moved. A single ball moves exactly as updatePhysicsSwept moves it.
+    class BallSet {
+    public:
+        std::vector<float> x, y, vx, vy;
+
+        // the collision rect of a ball relative to its position
+        BallSet(float collOffsetX, float collOffsetY, float collW, float collH)
+            : collOffsetX(collOffsetX), collOffsetY(collOffsetY), collW(collW), collH(collH) {}
+
+        int size() const { return (int)x.size(); }
+
+        void add(float px, float py, float velX, float velY) {
+            x.push_back(px); y.push_back(py);
+            vx.push_back(velX); vy.push_back(velY);
+        }
+
+        void clear() {
+            x.clear(); y.clear(); vx.clear(); vy.clear();
+        }
+
+        // every ball gets a twin heading off the other way sideways, as long
+        // as that keeps the set within maxBalls
+        void split(int maxBalls) {
+            int n = size();
+            for (int i = 0; i < n && size() < maxBalls; i++)
+                add(x[i], y[i], -vx[i], vy[i]);
+        }
+
+        // one tick for every ball; returns the blocks destroyed, in index order
+        const std::vector<int>& update(std::vector<Block>& blocks, const BlockIndex& index, int windowWidth, int windowHeight) {
+            killed.clear();
+            int n = size();
+
+            for (int i = 0; i < n; i++) x[i] += vx[i];
+            collide(blocks, index, vx);
+
+            for (int i = 0; i < n; i++) y[i] += vy[i];
+            collide(blocks, index, vy);
+
+            // screen boundary checks - bounce when leaving window
+            for (int i = 0; i < n; i++) {
+                if (x[i] < 0 || x[i] > windowWidth) vx[i] = -vx[i];
+                if (y[i] < 0 || y[i] > windowHeight) vy[i] = -vy[i];
+            }
+
+            std::sort(killed.begin(), killed.end());
+            return killed;
+        }
+
+        // one swept tick for every ball; a ball whose collision rect ends up
+        // on the paddle is sent back up at bounceSpeed(), which returns a
+        // negative vertical velocity. Returns the blocks destroyed, in index order.
+        template<class BounceSpeed>
+        const std::vector<int>& updateSwept(std::vector<Block>& blocks, const BlockIndex& index, int windowWidth, int windowHeight,
+            const Rect& paddle, BounceSpeed bounceSpeed) {
+            killed.clear();
+            hits.clear();
+            int n = size();
+
+            for (int i = 0; i < n; i++) {
+                size_t own = hits.size(); // where this ball's hits start
+                sweepBall(x[i], y[i], vx[i], vy[i], blocks, index, collOffsetX, collOffsetY, collW, collH, SWEEP_MAX_HITS,
+                    [&](int b) { return blocks[b].alive && std::find(hits.begin() + own, hits.end(), b) == hits.end(); },
+                    [&](int b) { hits.push_back(b); });
+            }
+
+            for (int b : hits)
+                if (blocks[b].alive) {
+                    blocks[b].alive = false;
+                    killed.push_back(b);
+                }
+
+            for (int i = 0; i < n; i++) {
+                // screen boundary checks - bounce when leaving window
+                if (x[i] < 0 || x[i] > windowWidth) vx[i] = -vx[i];
+                if (y[i] < 0 || y[i] > windowHeight) vy[i] = -vy[i];
+
+                if (rectsIntersect(Rect{ x[i] + collOffsetX, y[i] + collOffsetY, collW, collH }, paddle))
+                    vy[i] = bounceSpeed();
+            }
+
+            std::sort(killed.begin(), killed.end());
+            return killed;
+        }
+
+    private:
+        float collOffsetX, collOffsetY, collW, collH;
+        std::vector<int> hits;   // blocks hit during the current step, maybe more than once
+        std::vector<int> killed; // blocks destroyed this tick
+
+        void collide(std::vector<Block>& blocks, const BlockIndex& index, std::vector<float>& vel) {
+            hits.clear();
+            for (int i = 0; i < size(); i++) {
+                Rect ball{ x[i] + collOffsetX, y[i] + collOffsetY, collW, collH };
+                index.forEachNear(ball, [&](int b) {
+                    if (!blocks[b].alive) return;
+                    if (rectsIntersect(ball, Rect{ blocks[b].x, blocks[b].y, index.blockWidth(), index.blockHeight() })) {
+                        vel[i] = -vel[i];
+                        hits.push_back(b);
+                    }
+                });
+            }
+
+            for (int b : hits)
+                if (blocks[b].alive) {
+                    blocks[b].alive = false;
+                    killed.push_back(b);
+                }
+        }
+    };
+
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 namespace Arkanoid {
@@ -33,22 +36,259 @@ namespace Arkanoid {
         }
     }
 
-    // move ball and detect collisions with blocks and screen bounds
-    inline void updatePhysics(float& ballPosX, float& ballPosY, float& ballVelX, float& ballVelY,
-        std::vector<Block>& blocks,
-        float blockW, float blockH,
+    // blocks bucketed by the lattice cell their top left corner falls in
+    // (normally BLOCK_SPACING_X by BLOCK_SPACING_Y), so a ball only looks at
+    // the few cells it can overlap instead of at every block of the level
+    class BlockIndex {
+        float blockW, blockH, cellW, cellH;
+        float originX, originY;
+        int cols, rows;
+        std::vector<int> cellStart; // blocks of cell c are items[cellStart[c] .. cellStart[c + 1])
+        std::vector<int> items;
+
+        int cellOf(float v, float origin, float size, int count) const {
+            int c = (int)std::floor((v - origin) / size);
+            return c < 0 ? 0 : c >= count ? count - 1 : c;
+        }
+
+    public:
+        BlockIndex(const std::vector<Block>& blocks, float blockW, float blockH, float cellW, float cellH)
+            : blockW(blockW), blockH(blockH), cellW(cellW), cellH(cellH), originX(0), originY(0), cols(0), rows(0) {
+            if (blocks.empty()) return;
+
+            float maxX = blocks[0].x, maxY = blocks[0].y;
+            originX = blocks[0].x, originY = blocks[0].y;
+            for (auto& b : blocks) {
+                originX = std::min(originX, b.x); maxX = std::max(maxX, b.x);
+                originY = std::min(originY, b.y); maxY = std::max(maxY, b.y);
+            }
+            cols = (int)std::floor((maxX - originX) / cellW) + 1;
+            rows = (int)std::floor((maxY - originY) / cellH) + 1;
+
+            // counting sort of the blocks by cell
+            std::vector<int> cellOfBlock(blocks.size());
+            cellStart.assign(cols * rows + 1, 0);
+            for (size_t i = 0; i < blocks.size(); i++) {
+                int c = cellOf(blocks[i].y, originY, cellH, rows) * cols + cellOf(blocks[i].x, originX, cellW, cols);
+                cellOfBlock[i] = c;
+                cellStart[c + 1]++;
+            }
+            for (int c = 0; c < cols * rows; c++) cellStart[c + 1] += cellStart[c];
+            items.resize(blocks.size());
+            std::vector<int> next(cellStart.begin(), cellStart.end() - 1);
+            for (size_t i = 0; i < blocks.size(); i++) items[next[cellOfBlock[i]]++] = (int)i;
+        }
+
+        float blockWidth() const { return blockW; }
+        float blockHeight() const { return blockH; }
+
+        // calls visit(i) for every block whose rect could overlap r, in
+        // row-major cell order and block order within a cell
+        template<class Visit>
+        void forEachNear(const Rect& r, Visit visit) const {
+            if (cols == 0) return;
+            // a block at bx overlaps r only if r.x - blockW < bx < r.x + r.w
+            float x0 = r.x - blockW, x1 = r.x + r.w, y0 = r.y - blockH, y1 = r.y + r.h;
+            if (x1 < originX || y1 < originY || x0 >= originX + cols * cellW || y0 >= originY + rows * cellH) return;
+
+            int cx0 = cellOf(x0, originX, cellW, cols), cx1 = cellOf(x1, originX, cellW, cols);
+            int cy0 = cellOf(y0, originY, cellH, rows), cy1 = cellOf(y1, originY, cellH, rows);
+            for (int cy = cy0; cy <= cy1; cy++)
+                for (int cx = cx0; cx <= cx1; cx++) {
+                    int c = cy * cols + cx;
+                    for (int k = cellStart[c]; k < cellStart[c + 1]; k++) visit(items[k]);
+                }
+        }
+    };
+
+    // same as above, looking only at the blocks the index places near the rect;
+    // the index of each block destroyed is added to `killed` if given
+    inline void checkBlockCollisions(std::vector<Block>& blocks, const BlockIndex& index, const Rect& collisionRect, float& vel,
+        std::vector<int>* killed = nullptr)
+    {
+        index.forEachNear(collisionRect, [&](int i) {
+            Block& b = blocks[i];
+            if (!b.alive) return;
+            Rect blockRect{ b.x, b.y, index.blockWidth(), index.blockHeight() };
+            if (rectsIntersect(collisionRect, blockRect)) {
+                b.alive = false;
+                vel = -vel;
+                if (killed) killed->push_back(i);
+            }
+        });
+    }
+
+    // the live blocks packed at the front of a list, e.g. one quad each in a
+    // vertex array; removing one moves the last entry into its place
+    class AliveBlocks {
+        std::vector<int> order; // indices of the live blocks
+        std::vector<int> slot;  // where each block sits in order, -1 once removed
+
+    public:
+        explicit AliveBlocks(const std::vector<Block>& blocks) : slot(blocks.size(), -1) {
+            for (size_t i = 0; i < blocks.size(); i++)
+                if (blocks[i].alive) {
+                    slot[i] = (int)order.size();
+                    order.push_back((int)i);
+                }
+        }
+
+        int size() const { return (int)order.size(); }
+        int operator[](int s) const { return order[s]; }
+
+        // returns the slot the block was in, which now holds what was the
+        // last entry (slot == size() if it was the last), or -1 if it was gone
+        int remove(int block) {
+            int s = slot[block];
+            if (s < 0) return -1;
+            int last = order.back();
+            order[s] = last;
+            slot[last] = s;
+            order.pop_back();
+            slot[block] = -1;
+            return s;
+        }
+    };
+
+    // the ball step shared by both ways of finding blocks; check(rect, vel)
+    // kills the blocks hit by rect and flips vel
+    template<class CheckBlocks>
+    void moveBall(float& ballPosX, float& ballPosY, float& ballVelX, float& ballVelY,
         float ballCollOffsetX, float ballCollOffsetY, float ballCollW, float ballCollH,
-        int windowWidth, int windowHeight)
+        int windowWidth, int windowHeight, CheckBlocks check)
     {
         // Horizontal movement step
         ballPosX += ballVelX; // move ball horizontally
         Rect ballCollisionRectH{ ballPosX + ballCollOffsetX, ballPosY + ballCollOffsetY, ballCollW, ballCollH };
-        checkBlockCollisions(blocks, ballCollisionRectH, blockW, blockH, ballVelX);
+        check(ballCollisionRectH, ballVelX);
 
         // Vertical movement step
         ballPosY += ballVelY; // move ball vertically
         Rect ballCollisionRectV{ ballPosX + ballCollOffsetX, ballPosY + ballCollOffsetY, ballCollW, ballCollH };
-        checkBlockCollisions(blocks, ballCollisionRectV, blockW, blockH, ballVelY);
+        check(ballCollisionRectV, ballVelY);
+
+        // screen boundary checks - bounce when leaving window
+        if (ballPosX < 0 || ballPosX > windowWidth)
+            ballVelX = -ballVelX;
+        if (ballPosY < 0 || ballPosY > windowHeight)
+            ballVelY = -ballVelY;
+    }
+
+    // move ball and detect collisions with blocks and screen bounds
+    inline void updatePhysics(float& ballPosX, float& ballPosY, float& ballVelX, float& ballVelY,
+        std::vector<Block>& blocks,
+        float blockW, float blockH,
+        float ballCollOffsetX, float ballCollOffsetY, float ballCollW, float ballCollH,
+        int windowWidth, int windowHeight)
+    {
+        moveBall(ballPosX, ballPosY, ballVelX, ballVelY, ballCollOffsetX, ballCollOffsetY, ballCollW, ballCollH,
+            windowWidth, windowHeight, [&](const Rect& r, float& vel) {
+                checkBlockCollisions(blocks, r, blockW, blockH, vel);
+            });
+    }
+
+    // same, with the blocks looked up through an index built over them
+    inline void updatePhysics(float& ballPosX, float& ballPosY, float& ballVelX, float& ballVelY,
+        std::vector<Block>& blocks, const BlockIndex& index,
+        float ballCollOffsetX, float ballCollOffsetY, float ballCollW, float ballCollH,
+        int windowWidth, int windowHeight, std::vector<int>* killed = nullptr)
+    {
+        moveBall(ballPosX, ballPosY, ballVelX, ballVelY, ballCollOffsetX, ballCollOffsetY, ballCollW, ballCollH,
+            windowWidth, windowHeight, [&](const Rect& r, float& vel) {
+                checkBlockCollisions(blocks, index, r, vel, killed);
+            });
+    }
+
+    // when a rect moving by (dx, dy) first touches a still one: t in [0, 1]
+    // is the fraction of the move done at contact, hitX / hitY the sides it
+    // meets (both for an exact corner). Rects already overlapping don't hit.
+    inline bool sweptRects(const Rect& moving, float dx, float dy, const Rect& still, float& t, bool& hitX, bool& hitY)
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+        float entryX = -inf, exitX = inf, entryY = -inf, exitY = inf;
+
+        if (dx > 0) { entryX = (still.x - (moving.x + moving.w)) / dx; exitX = (still.x + still.w - moving.x) / dx; }
+        else if (dx < 0) { entryX = (still.x + still.w - moving.x) / dx; exitX = (still.x - (moving.x + moving.w)) / dx; }
+        else if (moving.x + moving.w <= still.x || still.x + still.w <= moving.x) return false;
+
+        if (dy > 0) { entryY = (still.y - (moving.y + moving.h)) / dy; exitY = (still.y + still.h - moving.y) / dy; }
+        else if (dy < 0) { entryY = (still.y + still.h - moving.y) / dy; exitY = (still.y - (moving.y + moving.h)) / dy; }
+        else if (moving.y + moving.h <= still.y || still.y + still.h <= moving.y) return false;
+
+        float entry = std::max(entryX, entryY), exit = std::min(exitX, exitY);
+        if (entry >= exit || entry < 0 || entry > 1) return false;
+
+        t = entry;
+        hitX = entryX >= entryY;
+        hitY = entryY >= entryX;
+        return true;
+    }
+
+    // hits one swept ball step may take before the rest of the move is dropped
+    const int SWEEP_MAX_HITS = 4;
+
+    // the swept move of one ball, without the window bounce: canHit(i) says
+    // whether block i is there to be hit, hit(i) is called for each block the
+    // ball bounces off
+    template<class CanHit, class Hit>
+    void sweepBall(float& ballPosX, float& ballPosY, float& ballVelX, float& ballVelY,
+        const std::vector<Block>& blocks, const BlockIndex& index,
+        float ballCollOffsetX, float ballCollOffsetY, float ballCollW, float ballCollH,
+        int maxHits, CanHit canHit, Hit hit)
+    {
+        float remaining = 1; // share of this tick's move still to do
+        for (int hits = 0; hits < maxHits && remaining > 0; hits++) {
+            float dx = ballVelX * remaining, dy = ballVelY * remaining;
+            Rect ball{ ballPosX + ballCollOffsetX, ballPosY + ballCollOffsetY, ballCollW, ballCollH };
+            Rect path{ ball.x + std::min(dx, 0.f), ball.y + std::min(dy, 0.f), ball.w + std::abs(dx), ball.h + std::abs(dy) };
+
+            int first = -1;
+            float firstT = 2;
+            bool firstX = false, firstY = false;
+            index.forEachNear(path, [&](int i) {
+                if (!canHit(i)) return;
+                float t;
+                bool hitX, hitY;
+                Rect blockRect{ blocks[i].x, blocks[i].y, index.blockWidth(), index.blockHeight() };
+                if (sweptRects(ball, dx, dy, blockRect, t, hitX, hitY) && (t < firstT || (t == firstT && i < first))) {
+                    first = i; firstT = t; firstX = hitX; firstY = hitY;
+                }
+            });
+
+            if (first < 0) {
+                ballPosX += dx;
+                ballPosY += dy;
+                break;
+            }
+
+            ballPosX += dx * firstT;
+            ballPosY += dy * firstT;
+            hit(first);
+            if (firstX) ballVelX = -ballVelX;
+            if (firstY) ballVelY = -ballVelY;
+            remaining *= 1 - firstT;
+        }
+    }
+
+    // move the ball continuously: find the first block it would touch on the
+    // way, stop there, kill the block and bounce, then carry on with the rest
+    // of the tick (after maxHits hits the rest of the move is dropped).
+    // Fast balls can't pass through blocks and each hit flips the velocity
+    // once, however many blocks the end position would overlap. A tie goes
+    // to the block with the lowest index. Killed blocks are added to
+    // `killed` when it is given, as with the indexed updatePhysics.
+    inline void updatePhysicsSwept(float& ballPosX, float& ballPosY, float& ballVelX, float& ballVelY,
+        std::vector<Block>& blocks, const BlockIndex& index,
+        float ballCollOffsetX, float ballCollOffsetY, float ballCollW, float ballCollH,
+        int windowWidth, int windowHeight, std::vector<int>* killed = nullptr, int maxHits = SWEEP_MAX_HITS)
+    {
+        sweepBall(ballPosX, ballPosY, ballVelX, ballVelY, blocks, index,
+            ballCollOffsetX, ballCollOffsetY, ballCollW, ballCollH, maxHits,
+            [&](int i) { return blocks[i].alive; },
+            [&](int i) {
+                blocks[i].alive = false;
+                if (killed) killed->push_back(i);
+            });
 
         // screen boundary checks - bounce when leaving window
         if (ballPosX < 0 || ballPosX > windowWidth)
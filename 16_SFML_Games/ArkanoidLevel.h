@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ArkanoidCollision.h"
+
+namespace Arkanoid {
+
+    // A level is a lattice of block positions. On disk it is plain text:
+    //
+    //   # comments start with a hash and a space
+    //   spacing 43 20       distance between lattice cells, in pixels
+    //   origin 43 20        position of the top left cell
+    //   ##########          then one line per lattice row, one character per
+    //   #.#.#.#.#.          cell: '#' is a block, anything else is empty
+    //
+    // so a level costs one byte per cell and generated levels of any size
+    // can be fed to the game without recompiling. A comment may go anywhere,
+    // between the rows too; the space tells it apart from a row, so write
+    // empty cells as '.'.
+    struct Level {
+        float spacingX, spacingY;
+        float originX, originY;
+        std::vector<Block> blocks;
+    };
+
+    // cols x rows blocks, every cell filled
+    inline Level latticeLevel(int cols, int rows, float spacingX, float spacingY, float originX, float originY)
+    {
+        Level level{ spacingX, spacingY, originX, originY, {} };
+        for (int i = 0; i < cols; i++)
+            for (int j = 0; j < rows; j++)
+                level.blocks.push_back(Block{ originX + i * spacingX, originY + j * spacingY, true });
+        return level;
+    }
+
+    // returns false, leaving `level` untouched, if the text is not a level
+    inline bool readLevel(std::istream& in, Level& level)
+    {
+        Level read{ 0, 0, 0, 0, {} };
+        bool haveSpacing = false, haveOrigin = false;
+        int row = 0;
+        std::string line;
+
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.compare(0, 2, "# ") == 0) continue;
+
+            // header: blank lines and the two settings
+            if (!(haveSpacing && haveOrigin)) {
+                if (line.empty()) continue;
+                std::istringstream words(line);
+                std::string key;
+                float a, b;
+                if (!(words >> key >> a >> b)) return false;
+                if (key == "spacing" && a > 0 && b > 0) { read.spacingX = a; read.spacingY = b; haveSpacing = true; }
+                else if (key == "origin") { read.originX = a; read.originY = b; haveOrigin = true; }
+                else return false;
+                continue;
+            }
+
+            for (size_t i = 0; i < line.size(); i++)
+                if (line[i] == '#')
+                    read.blocks.push_back(Block{ read.originX + i * read.spacingX, read.originY + row * read.spacingY, true });
+            row++;
+        }
+
+        if (!(haveSpacing && haveOrigin)) return false;
+        level = read;
+        return true;
+    }
+
+    inline bool loadLevel(const std::string& path, Level& level)
+    {
+        std::ifstream in(path);
+        return in && readLevel(in, level);
+    }
+
+    // blocks are snapped to the nearest lattice cell; dead blocks are left out
+    inline void writeLevel(std::ostream& out, const Level& level)
+    {
+        out << "spacing " << level.spacingX << " " << level.spacingY << "\n";
+        out << "origin " << level.originX << " " << level.originY << "\n";
+
+        int cols = 0, rows = 0;
+        std::vector<std::pair<int, int>> cells;
+        for (auto& b : level.blocks) {
+            if (!b.alive) continue;
+            int i = (int)std::lround((b.x - level.originX) / level.spacingX);
+            int j = (int)std::lround((b.y - level.originY) / level.spacingY);
+            if (i < 0 || j < 0) continue;
+            cells.push_back(std::make_pair(i, j));
+            cols = std::max(cols, i + 1);
+            rows = std::max(rows, j + 1);
+        }
+
+        std::vector<std::string> lines(rows, std::string(cols, '.'));
+        for (auto& c : cells) lines[c.second][c.first] = '#';
+        for (auto& l : lines) out << l << "\n";
+    }
+
+}
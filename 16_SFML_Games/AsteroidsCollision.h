@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+namespace Asteroids {
+
+    inline bool circlesOverlap(float ax, float ay, float aR, float bx, float by, float bR)
+    {
+        return (bx - ax) * (bx - ax) + (by - ay) * (by - ay) < (aR + bR) * (aR + bR);
+    }
+
+    // uniform grid broad-phase over the width x height playfield
+    // cells wrap at the screen edges, so a query near one border also
+    // visits the cells on the opposite border (the playfield is a torus)
+    // cellSize must be at least the largest sum of radii that is tested
+    class SpatialHash {
+        int cols, rows;
+        float cellW, cellH;
+        std::vector<std::vector<int>> cells;
+
+        int wrap(int i, int n) const {
+            i %= n;
+            return i < 0 ? i + n : i;
+        }
+
+        int column(float x) const { return wrap((int)std::floor(x / cellW), cols); }
+        int row(float y) const { return wrap((int)std::floor(y / cellH), rows); }
+
+        // neighbouring indices of i without repeats (small grids wrap onto themselves)
+        int neighbours(int i, int n, int out[3]) const {
+            int count = 0;
+            for (int d = -1; d <= 1; d++) {
+                int k = wrap(i + d, n);
+                bool seen = false;
+                for (int j = 0; j < count; j++)
+                    if (out[j] == k) seen = true;
+                if (!seen) out[count++] = k;
+            }
+            return count;
+        }
+
+    public:
+        SpatialHash(float width, float height, float cellSize) {
+            cols = (int)(width / cellSize);
+            rows = (int)(height / cellSize);
+            if (cols < 1) cols = 1;
+            if (rows < 1) rows = 1;
+            cellW = width / cols;
+            cellH = height / rows;
+            cells.resize(cols * rows);
+        }
+
+        // empties every cell but keeps the allocated capacity for the next frame
+        void clear() {
+            for (auto& c : cells) c.clear();
+        }
+
+        // bytes held by the cells; it only changes if one had to grow
+        size_t reservedBytes() const {
+            size_t bytes = cells.capacity() * sizeof(cells[0]);
+            for (auto& c : cells) bytes += c.capacity() * sizeof(int);
+            return bytes;
+        }
+
+        void insert(int id, float x, float y) {
+            cells[row(y) * cols + column(x)].push_back(id);
+        }
+
+        // calls visit(id) for every id stored in the 3x3 cells around (x, y)
+        template<class Visit>
+        void query(float x, float y, Visit visit) const {
+            int cs[3], rs[3];
+            int nc = neighbours(column(x), cols, cs);
+            int nr = neighbours(row(y), rows, rs);
+            for (int r = 0; r < nr; r++)
+                for (int c = 0; c < nc; c++)
+                    for (int id : cells[rs[r] * cols + cs[c]])
+                        visit(id);
+        }
+    };
+
+}
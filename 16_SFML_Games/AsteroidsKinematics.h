@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ASTEROIDS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Asteroids {
+
+    // structure-of-arrays copy of the moving entities of one kind
+    struct Motion
+    {
+        std::vector<float> x, y, dx, dy;
+        std::vector<unsigned char> outside;
+
+        void reserve(int n)
+        {
+            x.reserve(n); y.reserve(n); dx.reserve(n); dy.reserve(n);
+            outside.reserve(n);
+        }
+
+        void resize(int n)
+        {
+            x.resize(n); y.resize(n); dx.resize(n); dy.resize(n);
+            outside.resize(n);
+        }
+
+        size_t reservedBytes() const
+        {
+            return (x.capacity() + y.capacity() + dx.capacity() + dy.capacity()) * sizeof(float) + outside.capacity();
+        }
+    };
+
+    // reference kernels, one entity at a time; the SIMD versions must match them bit for bit
+
+    // rocks: move, then reappear on the opposite edge of the w x h torus
+    inline void moveAndWrapScalar(float* x, float* y, const float* dx, const float* dy, int begin, int end, float w, float h)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            x[i] += dx[i];
+            y[i] += dy[i];
+
+            if (x[i] > w) x[i] = 0;
+            if (x[i] < 0) x[i] = w;
+            if (y[i] > h) y[i] = 0;
+            if (y[i] < 0) y[i] = h;
+        }
+    }
+
+    // bullets: move, then flag the ones that left the screen
+    inline void moveAndCullScalar(float* x, float* y, const float* dx, const float* dy, unsigned char* outside, int begin, int end, float w, float h)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            x[i] += dx[i];
+            y[i] += dy[i];
+
+            outside[i] = x[i] > w || x[i] < 0 || y[i] > h || y[i] < 0;
+        }
+    }
+
+#ifdef ASTEROIDS_SSE2
+    // mask ? replacement : a, four lanes at once
+    inline __m128 replaceWhere(__m128 mask, __m128 replacement, __m128 a)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, replacement), _mm_andnot_ps(mask, a));
+    }
+#endif
+
+    inline void moveAndWrap(float* x, float* y, const float* dx, const float* dy, int n, float w, float h)
+    {
+        int i = 0;
+#ifdef ASTEROIDS_SSE2
+        const __m128 zero = _mm_setzero_ps(), W = _mm_set1_ps(w), H = _mm_set1_ps(h);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(dx + i));
+            __m128 py = _mm_add_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(dy + i));
+
+            px = replaceWhere(_mm_cmpgt_ps(px, W), zero, px);
+            px = replaceWhere(_mm_cmplt_ps(px, zero), W, px);
+            py = replaceWhere(_mm_cmpgt_ps(py, H), zero, py);
+            py = replaceWhere(_mm_cmplt_ps(py, zero), H, py);
+
+            _mm_storeu_ps(x + i, px);
+            _mm_storeu_ps(y + i, py);
+        }
+#endif
+        moveAndWrapScalar(x, y, dx, dy, i, n, w, h);
+    }
+
+    inline void moveAndCull(float* x, float* y, const float* dx, const float* dy, unsigned char* outside, int n, float w, float h)
+    {
+        int i = 0;
+#ifdef ASTEROIDS_SSE2
+        const __m128 zero = _mm_setzero_ps(), W = _mm_set1_ps(w), H = _mm_set1_ps(h);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(dx + i));
+            __m128 py = _mm_add_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(dy + i));
+            _mm_storeu_ps(x + i, px);
+            _mm_storeu_ps(y + i, py);
+
+            __m128 out = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(px, W), _mm_cmplt_ps(px, zero)),
+                                   _mm_or_ps(_mm_cmpgt_ps(py, H), _mm_cmplt_ps(py, zero)));
+            int bits = _mm_movemask_ps(out);
+            for (int k = 0; k < 4; k++) outside[i + k] = (bits >> k) & 1;
+        }
+#endif
+        moveAndCullScalar(x, y, dx, dy, outside, i, n, w, h);
+    }
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+namespace Asteroids {
+
+    // stable reference to a pooled item; goes stale once the item is removed
+    struct Handle {
+        int slot;
+        unsigned generation;
+    };
+
+    // fixed-capacity slot map: items stay packed in one contiguous array,
+    // removal swaps the last item into the hole, and handles keep pointing
+    // at the right item across those moves
+    template<class T>
+    class Pool
+    {
+        struct Slot {
+            int dense;              // index into items, -1 when free
+            unsigned generation;
+        };
+
+        std::vector<T> items;
+        std::vector<int> owner;     // items[i] is addressed by slots[owner[i]]
+        std::vector<Slot> slots;
+        std::vector<int> freeSlots;
+
+        void removeAt(int i)
+        {
+            int last = (int)items.size() - 1;
+            Slot& gone = slots[owner[i]];
+            gone.dense = -1;
+            gone.generation++;
+            freeSlots.push_back(owner[i]);
+
+            if (i != last) {
+                items[i] = std::move(items[last]);
+                owner[i] = owner[last];
+                slots[owner[i]].dense = i;
+            }
+            items.pop_back();
+            owner.pop_back();
+        }
+
+    public:
+        explicit Pool(int capacity)
+        {
+            items.reserve(capacity);
+            owner.reserve(capacity);
+            slots.resize(capacity, Slot{ -1, 0 });
+            freeSlots.reserve(capacity);
+            for (int i = capacity - 1; i >= 0; i--) freeSlots.push_back(i);
+        }
+
+        int capacity() const { return (int)slots.size(); }
+        int size() const { return (int)items.size(); }
+        bool empty() const { return items.empty(); }
+        bool full() const { return freeSlots.empty(); }
+
+        // bytes held by the pool's buffers; it only changes if one was reallocated
+        size_t reservedBytes() const
+        {
+            return items.capacity() * sizeof(T) + owner.capacity() * sizeof(int) +
+                slots.capacity() * sizeof(Slot) + freeSlots.capacity() * sizeof(int);
+        }
+
+        // returns a handle with slot -1 when the pool is full
+        Handle add(const T& item)
+        {
+            if (full()) return Handle{ -1, 0 };
+
+            int s = freeSlots.back();
+            freeSlots.pop_back();
+            slots[s].dense = (int)items.size();
+            items.push_back(item);
+            owner.push_back(s);
+            return Handle{ s, slots[s].generation };
+        }
+
+        bool contains(Handle h) const
+        {
+            return h.slot >= 0 && h.slot < capacity() &&
+                slots[h.slot].generation == h.generation && slots[h.slot].dense >= 0;
+        }
+
+        // nullptr for stale handles; the pointer itself is only valid until the next removal
+        T* get(Handle h)
+        {
+            return contains(h) ? &items[slots[h.slot].dense] : nullptr;
+        }
+
+        void remove(Handle h)
+        {
+            if (contains(h)) removeAt(slots[h.slot].dense);
+        }
+
+        template<class Pred>
+        void removeIf(Pred dead)
+        {
+            for (int i = 0; i < (int)items.size();)
+                if (dead(items[i])) removeAt(i);
+                else i++;
+        }
+
+        void clear()
+        {
+            while (!items.empty()) removeAt((int)items.size() - 1);
+        }
+
+        T& operator[](int i) { return items[i]; }
+        const T& operator[](int i) const { return items[i]; }
+
+        typename std::vector<T>::iterator begin() { return items.begin(); }
+        typename std::vector<T>::iterator end() { return items.end(); }
+        typename std::vector<T>::const_iterator begin() const { return items.begin(); }
+        typename std::vector<T>::const_iterator end() const { return items.end(); }
+    };
+
+}
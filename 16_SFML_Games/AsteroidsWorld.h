@@ -0,0 +1,483 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "AsteroidsCollision.h"
+#include "AsteroidsKinematics.h"
+#include "AsteroidsPool.h"
+
+namespace Asteroids {
+
+    const int W = 1200;
+    const int H = 800;
+
+    const float DEGTORAD = 0.017453f;
+
+    // the simulation always advances in steps of this length, whatever the frame rate
+    const float TICK_SECONDS = 1.f / 60;
+
+    // xorshift32: small, fast and identical on every platform, unlike rand()
+    class Random
+    {
+        uint32_t bits;
+
+    public:
+        explicit Random(uint32_t seed) : bits(seed ? seed : 0x9E3779B9u) {}
+
+        uint32_t next()
+        {
+            bits ^= bits << 13;
+            bits ^= bits >> 17;
+            bits ^= bits << 5;
+            return bits;
+        }
+
+        // uniform-ish integer in [0, n)
+        int below(int n)
+        {
+            return int(next() % uint32_t(n));
+        }
+
+        uint32_t state() const { return bits; }
+    };
+
+    // player controls sampled for one tick
+    struct Input
+    {
+        bool left, right, thrust, fire;
+    };
+
+    // texture sheets, resolved to real textures by the renderer
+    enum Sheet { SPACESHIP, EXPLOSION_C, ROCK, FIRE_BLUE, ROCK_SMALL, EXPLOSION_B, SHEET_COUNT };
+
+    // what an entity is, so hot loops never compare names
+    enum class Kind : unsigned char { Asteroid, Bullet, Explosion, Player };
+
+    struct FrameRect { int left, top, width, height; };
+
+    // immutable frame table, built once and shared by every entity that plays it
+    class Animation
+    {
+    public:
+        float speed;
+        Sheet sheet;
+        std::vector<FrameRect> frames;
+
+        Animation() {}
+
+        Animation(Sheet s, int x, int y, int w, int h, int count, float Speed)
+        {
+            speed = Speed;
+            sheet = s;
+
+            for (int i = 0; i < count; i++)
+                frames.push_back(FrameRect{ x + i * w, y, w, h });
+        }
+    };
+
+
+    // an entity's position in a shared Animation; copying it never allocates
+    class FrameCursor
+    {
+    public:
+        const Animation* table;
+        float Frame;
+
+        FrameCursor() : table(nullptr), Frame(0) {}
+
+        void play(const Animation& a)
+        {
+            table = &a;
+            Frame = 0;
+        }
+
+        void update()
+        {
+            Frame += table->speed;
+            int n = table->frames.size();
+            if (Frame >= n) Frame -= n;
+        }
+
+        bool isEnd() const
+        {
+            return Frame + table->speed >= table->frames.size();
+        }
+
+        Sheet sheet() const
+        {
+            return table->sheet;
+        }
+
+        const FrameRect& current() const
+        {
+            return table->frames[int(Frame)];
+        }
+    };
+
+
+    class Entity
+    {
+    public:
+        float x, y, dx, dy, R, angle;
+        bool life;
+        Kind kind;
+        FrameCursor anim;
+
+        Entity(Kind k = Kind::Explosion) : kind(k)
+        {
+            life = 1;
+        }
+
+        void settings(const Animation& a, int X, int Y, float Angle = 0, int radius = 1)
+        {
+            anim.play(a);
+            x = X; y = Y;
+            angle = Angle;
+            R = radius;
+        }
+
+        void update() {};
+    };
+
+
+    class asteroid : public Entity
+    {
+    public:
+        asteroid() : Entity(Kind::Asteroid)
+        {
+            dx = 0;
+            dy = 0;
+        }
+
+        void update()
+        {
+            moveAndWrapScalar(&x, &y, &dx, &dy, 0, 1, W, H);
+        }
+    };
+
+
+    class bullet : public Entity
+    {
+    public:
+        bullet() : Entity(Kind::Bullet) {}
+
+        // a bullet never turns, so its velocity is worked out once here
+        void settings(const Animation& a, int X, int Y, float Angle = 0, int radius = 1)
+        {
+            Entity::settings(a, X, Y, Angle, radius);
+            dx = cos(angle * DEGTORAD) * 6;
+            dy = sin(angle * DEGTORAD) * 6;
+        }
+
+        void update()
+        {
+            unsigned char outside;
+            moveAndCullScalar(&x, &y, &dx, &dy, &outside, 0, 1, W, H);
+            if (outside) life = 0;
+        }
+    };
+
+
+    class player : public Entity
+    {
+    public:
+        bool thrust;
+
+        player() : Entity(Kind::Player)
+        {
+            thrust = false;
+        }
+
+        void update()
+        {
+            if (thrust)
+            {
+                dx += cos(angle * DEGTORAD) * 0.2;
+                dy += sin(angle * DEGTORAD) * 0.2;
+            }
+            else
+            {
+                dx *= 0.99;
+                dy *= 0.99;
+            }
+
+            int maxSpeed = 15;
+            float speed = sqrt(dx * dx + dy * dy);
+            if (speed > maxSpeed)
+            {
+                dx *= maxSpeed / speed;
+                dy *= maxSpeed / speed;
+            }
+
+            x += dx;
+            y += dy;
+
+            if (x > W) x = 0;
+            if (x < 0) x = W;
+            if (y > H) y = 0;
+            if (y < 0) y = H;
+        }
+    };
+
+
+    inline bool isCollide(const Entity& a, const Entity& b)
+    {
+        return circlesOverlap(a.x, a.y, a.R, b.x, b.y, b.R);
+    }
+
+
+    struct Animations
+    {
+        Animation explosion, rock, rockSmall, bullet, player, playerGo, explosionShip;
+    };
+
+    inline Animations defaultAnimations()
+    {
+        Animations a;
+        a.explosion = Animation(EXPLOSION_C, 0, 0, 256, 256, 48, 0.5);
+        a.rock = Animation(ROCK, 0, 0, 64, 64, 16, 0.2);
+        a.rockSmall = Animation(ROCK_SMALL, 0, 0, 64, 64, 16, 0.2);
+        a.bullet = Animation(FIRE_BLUE, 0, 0, 32, 64, 16, 0.8);
+        a.player = Animation(SPACESHIP, 40, 0, 40, 40, 1, 0);
+        a.playerGo = Animation(SPACESHIP, 40, 40, 40, 40, 1, 0);
+        a.explosionShip = Animation(EXPLOSION_B, 0, 0, 192, 192, 64, 0.5);
+        return a;
+    }
+
+
+    // all live entities, stored per kind in contiguous pools so each pass
+    // only visits the kinds it needs; the single ship lives inline
+    // entities point into `anims`, so a World is never copied
+    // step() is the whole game tick; given the same seed and the same inputs
+    // two worlds stay bit-identical, which is what replays and soak tests rely on
+    class World
+    {
+        Animations anims;
+        SpatialHash grid;
+        Motion rockMotion, bulletMotion;
+
+        template<class T>
+        static void gather(Pool<T>& entities, Motion& m)
+        {
+            m.resize(entities.size());
+            for (int i = 0; i < entities.size(); i++)
+            {
+                m.x[i] = entities[i].x;   m.y[i] = entities[i].y;
+                m.dx[i] = entities[i].dx; m.dy[i] = entities[i].dy;
+            }
+        }
+
+        template<class T>
+        static void scatter(Pool<T>& entities, const Motion& m)
+        {
+            for (int i = 0; i < entities.size(); i++)
+            {
+                entities[i].x = m.x[i];
+                entities[i].y = m.y[i];
+            }
+        }
+
+        // moves every rock and bullet in one batched SIMD pass over packed arrays
+        void moveRocksAndBullets()
+        {
+            gather(asteroids, rockMotion);
+            moveAndWrap(rockMotion.x.data(), rockMotion.y.data(), rockMotion.dx.data(), rockMotion.dy.data(),
+                asteroids.size(), W, H);
+            scatter(asteroids, rockMotion);
+
+            gather(bullets, bulletMotion);
+            moveAndCull(bulletMotion.x.data(), bulletMotion.y.data(), bulletMotion.dx.data(), bulletMotion.dy.data(),
+                bulletMotion.outside.data(), bullets.size(), W, H);
+            scatter(bullets, bulletMotion);
+            for (int i = 0; i < bullets.size(); i++)
+                if (bulletMotion.outside[i]) bullets[i].life = 0;
+        }
+
+        template<class T>
+        void animateAll(Pool<T>& entities)
+        {
+            for (auto& e : entities) e.anim.update();
+            entities.removeIf([](const T& e) { return e.life == false; });
+        }
+
+        void explode(const Animation& a, float x, float y)
+        {
+            Entity e(Kind::Explosion);
+            e.settings(a, x, y);
+            explosions.add(e);
+        }
+
+        template<class T>
+        void updateAll(Pool<T>& entities)
+        {
+            for (auto& e : entities)
+            {
+                e.update();
+                e.anim.update();
+            }
+            entities.removeIf([](const T& e) { return e.life == false; });
+        }
+
+    public:
+        Pool<asteroid> asteroids;
+        Pool<bullet> bullets;
+        Pool<Entity> explosions;
+        player ship;
+        player* p;
+        Random rng;
+        long long ticks;
+
+        // capacity is per kind; spawns beyond it are dropped
+        World(const Animations& a, uint32_t seed = 1, int capacity = 4096)
+            : anims(a), grid(W, H, 50), asteroids(capacity), bullets(capacity), explosions(capacity),
+              p(&ship), rng(seed), ticks(0)
+        {
+            rockMotion.reserve(capacity);
+            bulletMotion.reserve(capacity);
+
+            p->settings(anims.player, 200, 200, 0, 20);
+            p->dx = 0; p->dy = 0;
+        }
+
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        // bytes held by every buffer the world fills during play; a tick that
+        // leaves this unchanged has not reallocated anything
+        size_t reservedBytes() const
+        {
+            return asteroids.reservedBytes() + bullets.reservedBytes() + explosions.reservedBytes() +
+                grid.reservedBytes() + rockMotion.reservedBytes() + bulletMotion.reservedBytes();
+        }
+
+        Handle spawnAsteroid(int x, int y, float angle, bool small = false)
+        {
+            asteroid a;
+            a.settings(small ? anims.rockSmall : anims.rock, x, y, angle, small ? 15 : 25);
+            a.dx = rng.below(8) - 4;
+            a.dy = rng.below(8) - 4;
+            return asteroids.add(a);
+        }
+
+        // big rocks at random places, as at the start of a game
+        void spawnRocks(int count)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                int x = rng.below(W), y = rng.below(H);
+                spawnAsteroid(x, y, rng.below(360));
+            }
+        }
+
+        Handle fire()
+        {
+            bullet b;
+            b.settings(anims.bullet, p->x, p->y, p->angle, 10);
+            return bullets.add(b);
+        }
+
+        // asteroid x bullet and player x asteroid, over the rocks present at the start of the pass
+        // (pools never reallocate, so references stay valid while fragments are appended)
+        void collide()
+        {
+            int rocks = asteroids.size();
+            grid.clear();
+            for (int i = 0; i < rocks; i++) grid.insert(i, asteroids[i].x, asteroids[i].y);
+
+            for (auto& b : bullets)
+                grid.query(b.x, b.y, [&](int id)
+                {
+                    asteroid& a = asteroids[id];
+                    if (!isCollide(a, b)) return;
+
+                    a.life = false;
+                    b.life = false;
+
+                    explode(anims.explosion, a.x, a.y);
+
+                    if (a.R == 15) return;
+                    for (int i = 0; i < 2; i++)
+                        spawnAsteroid(a.x, a.y, rng.below(360), true);
+                });
+
+            grid.query(p->x, p->y, [&](int id)
+            {
+                asteroid& b = asteroids[id];
+                if (!isCollide(*p, b)) return;
+
+                b.life = false;
+
+                explode(anims.explosionShip, p->x, p->y);
+
+                p->settings(anims.player, W / 2, H / 2, 0, 20);
+                p->dx = 0; p->dy = 0;
+            });
+        }
+
+        // advance every entity one frame and drop the dead ones
+        void update()
+        {
+            if (p->thrust) p->anim.play(anims.playerGo);
+            else p->anim.play(anims.player);
+
+            for (auto& e : explosions)
+                if (e.anim.isEnd()) e.life = 0;
+
+            moveRocksAndBullets();
+            animateAll(asteroids);
+            animateAll(bullets);
+            updateAll(explosions);
+
+            p->update();
+            p->anim.update();
+        }
+
+        // one fixed-length game tick: controls, collisions, the odd new rock, movement
+        void step(const Input& in)
+        {
+            if (in.fire) fire();
+
+            if (in.right) p->angle += 3;
+            if (in.left)  p->angle -= 3;
+            p->thrust = in.thrust;
+
+            collide();
+
+            if (rng.below(150) == 0)
+            {
+                int y = rng.below(H);
+                spawnAsteroid(0, y, rng.below(360));
+            }
+
+            update();
+            ticks++;
+        }
+
+        // FNV-1a over the whole simulation state, for comparing runs and replays
+        uint64_t checksum() const
+        {
+            uint64_t h = 1469598103934665603ull;
+            auto mix = [&h](const void* data, size_t size) {
+                const unsigned char* bytes = (const unsigned char*)data;
+                for (size_t i = 0; i < size; i++) { h ^= bytes[i]; h *= 1099511628211ull; }
+            };
+            auto mixEntity = [&mix](const Entity& e) {
+                float f[6] = { e.x, e.y, e.dx, e.dy, e.R, e.angle };
+                mix(f, sizeof f);
+                mix(&e.life, sizeof e.life);
+                mix(&e.anim.Frame, sizeof e.anim.Frame);
+            };
+
+            for (auto& e : asteroids) mixEntity(e);
+            for (auto& e : bullets) mixEntity(e);
+            for (auto& e : explosions) mixEntity(e);
+            mixEntity(*p);
+
+            uint32_t r = rng.state();
+            mix(&r, sizeof r);
+            mix(&ticks, sizeof ticks);
+            return h;
+        }
+    };
+
+}
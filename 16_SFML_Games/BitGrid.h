@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "FloodFill.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline int popcount64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return (int)__popcnt64(v);
+#elif defined(_MSC_VER)
+    return (int)(__popcnt((unsigned)v) + __popcnt((unsigned)(v >> 32)));
+#else
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+#endif
+}
+
+// Same interface as Grid, but each tile state is a bit plane (one bit per
+// cell, 64 cells per word): WALL, NEW_WALL and reachable-by-an-enemy.
+// Empty cells are the ones with no bit set. Filling and counting work on
+// whole words, so a capture touches cols / 64 words per row instead of cols tiles.
+class BitGrid {
+public:
+    enum tile : signed char { EMPTY = 0, WALL = 1, NEW_WALL = 2, NOT_TO_BE_FILLED = -1 };
+
+private:
+    int rows, cols, cellSize, wordsPerRow;
+    std::vector<uint64_t> wallBits, newWallBits, reachableBits;
+    std::vector<uint64_t> border; // the outer ring, which is always wall
+    uint64_t lastWordMask;        // valid bits of the last word in a row
+
+    int index(int y, int x) const { return y * wordsPerRow + x / 64; }
+    static uint64_t bit(int x) { return uint64_t(1) << (x % 64); }
+    bool test(const std::vector<uint64_t>& plane, int y, int x) const { return (plane[index(y, x)] & bit(x)) != 0; }
+
+    uint64_t rowMask(int w) const { return w == wordsPerRow - 1 ? lastWordMask : ~uint64_t(0); }
+    uint64_t open(int y, int w) const {
+        int i = y * wordsPerRow + w;
+        return ~(wallBits[i] | newWallBits[i] | reachableBits[i]) & rowMask(w);
+    }
+
+    // spreads the reachable bits of row y sideways through its empty cells;
+    // within a word this is a Kogge-Stone occluded fill, across words a carry
+    // returns true if anything new was marked
+    bool spreadAlongRow(int y) {
+        bool changed = false;
+        uint64_t* r = &reachableBits[y * wordsPerRow];
+        for (int pass = 0; pass < 2; pass++) {
+            bool carryIn = false;
+            for (int k = 0; k < wordsPerRow; k++) {
+                int w = pass == 0 ? k : wordsPerRow - 1 - k;
+                uint64_t e = open(y, w) | r[w];
+                uint64_t g = r[w];
+                uint64_t edge = pass == 0 ? 1 : uint64_t(1) << 63;
+                if (carryIn) g |= e & edge;
+
+                uint64_t p = e;
+                if (pass == 0) {
+                    g |= p & (g << 1);  p &= p << 1;
+                    g |= p & (g << 2);  p &= p << 2;
+                    g |= p & (g << 4);  p &= p << 4;
+                    g |= p & (g << 8);  p &= p << 8;
+                    g |= p & (g << 16); p &= p << 16;
+                    g |= p & (g << 32);
+                }
+                else {
+                    g |= p & (g >> 1);  p &= p >> 1;
+                    g |= p & (g >> 2);  p &= p >> 2;
+                    g |= p & (g >> 4);  p &= p >> 4;
+                    g |= p & (g >> 8);  p &= p >> 8;
+                    g |= p & (g >> 16); p &= p >> 16;
+                    g |= p & (g >> 32);
+                }
+
+                if (g != r[w]) { r[w] = g; changed = true; }
+                carryIn = (g & (pass == 0 ? uint64_t(1) << 63 : 1)) != 0;
+            }
+        }
+        return changed;
+    }
+
+    // marks empty cells of row y that sit directly below/above a reachable cell of row `from`
+    bool spreadFromRow(int y, int from) {
+        bool changed = false;
+        for (int w = 0; w < wordsPerRow; w++) {
+            uint64_t add = reachableBits[from * wordsPerRow + w] & open(y, w);
+            if (add) { reachableBits[y * wordsPerRow + w] |= add; changed = true; }
+        }
+        return changed;
+    }
+
+public:
+    BitGrid(int height = 25, int width = 40, int tileSize = 18)
+        : rows(height), cols(width), cellSize(tileSize), wordsPerRow((width + 63) / 64) {
+        lastWordMask = cols % 64 ? (uint64_t(1) << (cols % 64)) - 1 : ~uint64_t(0);
+        wallBits.assign(rows * wordsPerRow, 0);
+        newWallBits.assign(rows * wordsPerRow, 0);
+        reachableBits.assign(rows * wordsPerRow, 0);
+        border.assign(rows * wordsPerRow, 0);
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                if (i == 0 || j == 0 || i == rows - 1 || j == cols - 1)
+                    border[index(i, j)] |= bit(j);
+        wallBits = border;
+    }
+
+    int height() const { return rows; }
+    int width() const { return cols; }
+    int tileSize() const { return cellSize; }
+
+    int cell(int y, int x) {
+        if (test(reachableBits, y, x)) return NOT_TO_BE_FILLED;
+        if (test(wallBits, y, x)) return WALL;
+        if (test(newWallBits, y, x)) return NEW_WALL;
+        return EMPTY;
+    }
+
+    // same seeding rule as Grid: each enemy's cell and its four neighbours
+    void markConnectedCellsNotToBeFilled(const std::vector<Seed>& from) {
+        for (Seed s : from) {
+            const Seed around[5] = { s, { s.y - 1, s.x }, { s.y + 1, s.x }, { s.y, s.x - 1 }, { s.y, s.x + 1 } };
+            for (Seed c : around)
+                if (c.y >= 0 && c.y < rows && c.x >= 0 && c.x < cols && isEmpty(c.y, c.x))
+                    reachableBits[index(c.y, c.x)] |= bit(c.x);
+        }
+
+        // sweep down then up until nothing changes; each sweep carries
+        // reachability along rows and on to the next row
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int y = 0; y < rows; y++) {
+                if (y > 0) changed |= spreadFromRow(y, y - 1);
+                changed |= spreadAlongRow(y);
+            }
+            for (int y = rows - 1; y >= 0; y--) {
+                if (y < rows - 1) changed |= spreadFromRow(y, y + 1);
+                changed |= spreadAlongRow(y);
+            }
+        }
+    }
+
+    void markConnectedCellsNotToBeFilled(int y, int x) {
+        markConnectedCellsNotToBeFilled(std::vector<Seed>{ Seed{ y, x } });
+    }
+
+    // everything not reachable by an enemy becomes wall, 64 cells per step
+    void fillEmptyCells() {
+        for (int y = 0; y < rows; y++)
+            for (int w = 0; w < wordsPerRow; w++) {
+                int i = y * wordsPerRow + w;
+                wallBits[i] = ~reachableBits[i] & rowMask(w);
+                newWallBits[i] = 0;
+                reachableBits[i] = 0;
+            }
+    }
+
+    int wallCount() const {
+        int n = 0;
+        for (uint64_t w : wallBits) n += popcount64(w);
+        return n;
+    }
+
+    // share of the inside of the board (border excluded) that is wall
+    float capturedPercent() const {
+        int inside = (rows - 2) * (cols - 2);
+        int borderCells = rows * cols - inside;
+        return inside > 0 ? 100.f * (wallCount() - borderCells) / inside : 0.f;
+    }
+
+    bool levelComplete(float targetPercent = 75.f) const {
+        return capturedPercent() >= targetPercent;
+    }
+
+    bool pointInWall(int y, int x) {
+        return test(wallBits, y / cellSize, x / cellSize);
+    }
+
+    bool pointInNewWall(int y, int x) {
+        return cell(y / cellSize, x / cellSize) == NEW_WALL;
+    }
+
+    void clear() {
+        wallBits = border;
+        std::fill(newWallBits.begin(), newWallBits.end(), 0);
+        std::fill(reachableBits.begin(), reachableBits.end(), 0);
+    }
+
+    bool cellIsNewWall(int y, int x) {
+        return cell(y, x) == NEW_WALL;
+    }
+
+    void newWall(int y, int x) {
+        if (isEmpty(y, x)) newWallBits[index(y, x)] |= bit(x);
+    }
+
+    bool isWall(int y, int x) {
+        return cell(y, x) == WALL;
+    }
+    bool isNewWall(int y, int x) {
+        return cell(y, x) == NEW_WALL;
+    }
+    bool isEmpty(int y, int x) {
+        return cell(y, x) == EMPTY;
+    }
+};
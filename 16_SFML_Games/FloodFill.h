@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+struct Seed {
+    int y, x;
+};
+
+// Replaces every `from` cell 4-connected to a seed with `to`, one horizontal
+// span at a time. Uses an explicit stack instead of recursion, so board size
+// is limited by memory rather than by the call stack.
+// `cells` is height * width, row-major. Returns how many cells were changed.
+template<class Cell>
+int scanlineFill(Cell* cells, int height, int width, const std::vector<Seed>& seeds, Cell from, Cell to,
+                  std::vector<Seed>& stack)
+{
+    int filled = 0;
+    stack.assign(seeds.begin(), seeds.end());
+
+    while (!stack.empty()) {
+        Seed s = stack.back();
+        stack.pop_back();
+        if (s.y < 0 || s.y >= height || s.x < 0 || s.x >= width) continue;
+
+        Cell* row = cells + s.y * width;
+        if (row[s.x] != from) continue;
+
+        int left = s.x, right = s.x;
+        while (left > 0 && row[left - 1] == from) left--;
+        while (right < width - 1 && row[right + 1] == from) right++;
+        for (int x = left; x <= right; x++) row[x] = to;
+        filled += right - left + 1;
+
+        // queue the first cell of every run of `from` cells just above and below the span
+        for (int ny = s.y - 1; ny <= s.y + 1; ny += 2) {
+            if (ny < 0 || ny >= height) continue;
+            Cell* next = cells + ny * width;
+            bool inRun = false;
+            for (int x = left; x <= right; x++) {
+                bool open = next[x] == from;
+                if (open && !inRun) stack.push_back(Seed{ ny, x });
+                inRun = open;
+            }
+        }
+    }
+    return filled;
+}
+
+template<class Cell>
+int scanlineFill(Cell* cells, int height, int width, const std::vector<Seed>& seeds, Cell from, Cell to)
+{
+    std::vector<Seed> stack;
+    return scanlineFill(cells, height, width, seeds, from, to, stack);
+}
@@ -1,76 +1,157 @@
 #pragma once
+
+#include <vector>
+#include "FloodFill.h"
+
 class Grid {
 public: // so can be used by tests
-    enum tile { EMPTY = 0, WALL = 1, NEW_WALL = 2, NOT_TO_BE_FILLED = -1 };
+    enum tile : signed char { EMPTY = 0, WALL = 1, NEW_WALL = 2, NOT_TO_BE_FILLED = -1 };
 
 private:
-    tile grid[HEIGHT][WIDTH] = { EMPTY };
+    int rows, cols, cellSize;
+    std::vector<tile> tiles; // rows * cols, row-major, one byte per cell
+    int walls;               // number of WALL tiles, kept up to date by every change
+    int marked;              // number of NOT_TO_BE_FILLED tiles
+    std::vector<Seed> seeds, stack; // flood fill scratch, kept to avoid reallocating
 
+    // cells whose look changed since a renderer last asked; past a quarter
+    // of the board it is cheaper to say "everything" than to list them
+    std::vector<Seed> dirty;
+    bool allDirty;
+
+    tile& at(int y, int x) {
+        return tiles[y * cols + x];
+    }
 
+    void touched(int y, int x) {
+        if (allDirty) return;
+        if ((int)dirty.size() >= rows * cols / 4) {
+            allDirty = true;
+            dirty.clear();
+            return;
+        }
+        dirty.push_back(Seed{ y, x });
+    }
 
 public:
-    Grid() {
-        for (int i = 0; i < HEIGHT; i++)
-            for (int j = 0; j < WIDTH; j++)
-                if (i == 0 || j == 0 || i == HEIGHT - 1 || j == WIDTH - 1)
-                    grid[i][j] = WALL;
+    // the default is the classic 25 x 40 board of 18 pixel tiles
+    Grid(int height = 25, int width = 40, int tileSize = 18)
+        : rows(height), cols(width), cellSize(tileSize), tiles(height * width, EMPTY), walls(0), marked(0), allDirty(true) {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                if (i == 0 || j == 0 || i == rows - 1 || j == cols - 1) {
+                    at(i, j) = WALL;
+                    walls++;
+                }
+    }
+
+    int height() const { return rows; }
+    int width() const { return cols; }
+    int tileSize() const { return cellSize; }
+
+    int cell(int y, int x) const {
+        return tiles[y * cols + x];
     }
 
-    int cell(int y, int x) {
-        return grid[y][x];
+    // marks every empty cell reachable from any of the given cells (one per enemy)
+    // the neighbours are seeded too, as an enemy may sit on a wall cell itself
+    void markConnectedCellsNotToBeFilled(const std::vector<Seed>& from) {
+        seeds.clear();
+        for (Seed s : from) {
+            seeds.push_back(s);
+            seeds.push_back(Seed{ s.y - 1, s.x });
+            seeds.push_back(Seed{ s.y + 1, s.x });
+            seeds.push_back(Seed{ s.y, s.x - 1 });
+            seeds.push_back(Seed{ s.y, s.x + 1 });
+        }
+        marked += scanlineFill(tiles.data(), rows, cols, seeds, EMPTY, NOT_TO_BE_FILLED, stack);
     }
 
     void markConnectedCellsNotToBeFilled(int y, int x) {
-        if (grid[y][x] == EMPTY)
-            grid[y][x] = NOT_TO_BE_FILLED;
-        if (grid[y - 1][x] == EMPTY)
-            markConnectedCellsNotToBeFilled(y - 1, x);
-        if (grid[y + 1][x] == EMPTY)
-            markConnectedCellsNotToBeFilled(y + 1, x);
-        if (grid[y][x - 1] == EMPTY)
-            markConnectedCellsNotToBeFilled(y, x - 1);
-        if (grid[y][x + 1] == EMPTY)
-            markConnectedCellsNotToBeFilled(y, x + 1);
+        markConnectedCellsNotToBeFilled(std::vector<Seed>{ Seed{ y, x } });
     }
 
     void fillEmptyCells() {
-        for (int i = 0; i < HEIGHT; i++)
-            for (int j = 0; j < WIDTH; j++)
-                if (grid[i][j] == NOT_TO_BE_FILLED)
-                    grid[i][j] = EMPTY;
-                else
-                    grid[i][j] = WALL;
+        for (int i = 0; i < rows * cols; i++) {
+            tile& t = tiles[i];
+            if (t == NOT_TO_BE_FILLED)
+                t = EMPTY;
+            else {
+                if (t != WALL) touched(i / cols, i % cols);
+                t = WALL;
+            }
+        }
+        walls = rows * cols - marked;
+        marked = 0;
+    }
+
+    int wallCount() const {
+        return walls;
+    }
+
+    // share of the inside of the board (border excluded) that is wall
+    float capturedPercent() const {
+        int inside = (rows - 2) * (cols - 2);
+        int borderCells = rows * cols - inside;
+        return inside > 0 ? 100.f * (wallCount() - borderCells) / inside : 0.f;
+    }
+
+    bool levelComplete(float targetPercent = 75.f) const {
+        return capturedPercent() >= targetPercent;
     }
 
     bool pointInWall(int y, int x) {
-        return grid[y / tileSize][x / tileSize] == WALL;
+        return at(y / cellSize, x / cellSize) == WALL;
     }
 
     bool pointInNewWall(int y, int x) {
-        return grid[y / tileSize][x / tileSize] == NEW_WALL;
+        return at(y / cellSize, x / cellSize) == NEW_WALL;
     }
 
     void clear() {
-        for (int i = 1; i < HEIGHT - 1; i++)
-            for (int j = 1; j < WIDTH - 1; j++)
-                grid[i][j] = EMPTY;
+        for (int i = 1; i < rows - 1; i++)
+            for (int j = 1; j < cols - 1; j++)
+                at(i, j) = EMPTY;
+        walls = rows * cols - (rows - 2) * (cols - 2);
+        marked = 0;
+        allDirty = true;
+        dirty.clear();
     }
 
     bool cellIsNewWall(int y, int x) {
-        return grid[y][x] == NEW_WALL;
+        return at(y, x) == NEW_WALL;
     }
 
     void newWall(int y, int x) {
-        if (grid[y][x] == EMPTY) grid[y][x] = NEW_WALL;
+        if (at(y, x) == EMPTY) {
+            at(y, x) = NEW_WALL;
+            touched(y, x);
+        }
     }
 
     bool isWall(int y, int x) {
-        return grid[y][x] == WALL;
+        return at(y, x) == WALL;
     }
     bool isNewWall(int y, int x) {
-        return grid[y][x] == NEW_WALL;
+        return at(y, x) == NEW_WALL;
     }
     bool isEmpty(int y, int x) {
-        return grid[y][x] == EMPTY;
+        return at(y, x) == EMPTY;
+    }
+
+    // calls visit(y, x) for every cell changed since the previous call
+    // (every cell of the board after construction, clear or a big capture)
+    template<class Visit>
+    void takeDirtyCells(Visit visit) {
+        if (allDirty) {
+            for (int i = 0; i < rows; i++)
+                for (int j = 0; j < cols; j++)
+                    visit(i, j);
+        }
+        else {
+            for (Seed s : dirty) visit(s.y, s.x);
+        }
+        dirty.clear();
+        allDirty = false;
     }
 };
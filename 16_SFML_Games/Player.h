@@ -4,7 +4,9 @@ class Player {
 
 public:
     int x, y, dx, dy;
-    Player() {
+    int cols, rows; // the board the player is kept on, in tiles
+
+    Player(int width = 40, int height = 25) : cols(width), rows(height) {
         reset();
     }
 
@@ -16,9 +18,9 @@ public:
 
     void constrain() {
         if (x < 0) x = 0;
-        if (x > WIDTH - 1) x = WIDTH - 1;
+        if (x > cols - 1) x = cols - 1;
         if (y < 0) y = 0;
-        if (y > HEIGHT - 1) y = HEIGHT - 1;
+        if (y > rows - 1) y = rows - 1;
     }
 
     void stop() {
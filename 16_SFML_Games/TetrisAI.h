@@ -0,0 +1,223 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TetrisField.h"
+#include "TetrisPiece.h"
+
+namespace Tetris {
+
+    // A fixed set of worker threads that run forEach jobs together with the
+    // calling thread. forEach returns once every index has been processed.
+    class ThreadPool
+    {
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        const std::function<void(int)>* job = nullptr;
+        int count = 0;
+        std::atomic<int> next{ 0 };
+        int pending = 0;            // workers still busy with the current job
+        unsigned generation = 0;    // bumped for every job
+        bool stopping = false;
+
+        void runJobs(const std::function<void(int)>& body)
+        {
+            for (int i; (i = next.fetch_add(1)) < count; )
+                body(i);
+        }
+
+        void work()
+        {
+            unsigned seen = 0;
+            for (;;) {
+                const std::function<void(int)>* body;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                    body = job;
+                }
+                runJobs(*body);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--pending == 0) done.notify_one();
+                }
+            }
+        }
+
+    public:
+        // threads is the number of extra threads; 0 runs everything on the caller
+        explicit ThreadPool(int threads)
+        {
+            for (int i = 0; i < threads; i++)
+                workers.push_back(std::thread([this] { work(); }));
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto& w : workers) w.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int size() const { return (int)workers.size() + 1; }
+
+        // calls body(i) for i in [0, n), spread over the pool
+        void forEach(int n, const std::function<void(int)>& body)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = &body;
+                count = n;
+                next = 0;
+                pending = (int)workers.size();
+                generation++;
+            }
+            wake.notify_all();
+            runJobs(body);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return pending == 0; });
+            job = nullptr;
+        }
+    };
+
+    // weights of the board features, as in the usual hand-tuned placement bots
+    struct Weights
+    {
+        double height = -0.510066;
+        double lines = 0.760666;
+        double holes = -0.35663;
+        double bumpiness = -0.184483;
+    };
+
+    // higher is better: few holes, a low and flat stack, lines cleared
+    inline double evaluate(const Field& field, int lines, const Weights& w)
+    {
+        int heights[COLS] = {};
+        int holes = 0;
+        Field::Row seen = 0; // columns with a block at or above the current row
+        for (int y = 0; y < ROWS; y++) {
+            Field::Row row = field.bits(y) & ~Field::walls();
+            for (Field::Row fresh = row & ~seen; fresh; fresh &= fresh - 1)
+                for (int x = 0; x < COLS; x++)
+                    if (fresh & (Field::Row(1) << (x + Field::PAD))) { heights[x] = ROWS - y; break; }
+            for (Field::Row gaps = seen & ~row; gaps; gaps &= gaps - 1) holes++;
+            seen |= row;
+        }
+
+        int aggregate = 0, bumpiness = 0;
+        for (int x = 0; x < COLS; x++) {
+            aggregate += heights[x];
+            if (x > 0) bumpiness += heights[x] > heights[x - 1] ? heights[x] - heights[x - 1] : heights[x - 1] - heights[x];
+        }
+        return w.height * aggregate + w.lines * lines + w.holes * holes + w.bumpiness * bumpiness;
+    }
+
+    // one way to play a piece: where it is at the top of the well after
+    // turning and sliding, and where it comes to rest when dropped from there
+    struct Placement
+    {
+        Piece start;
+        Point landed[4];
+    };
+
+    // every placement reachable by turning (with kicks), then sliding, then
+    // dropping, that leaves the whole piece inside the well
+    inline void placements(const Field& field, int type, std::vector<Placement>& out)
+    {
+        out.clear();
+        Piece turned = spawnPiece(type);
+        if (!fits(field, turned)) return;
+
+        for (int r = 0; r < 4; r++) {
+            if (r > 0 && !rotate(field, turned, 1)) return;
+            if (type == O && r > 0) return; // every turn of an O is the same
+
+            for (int dir = -1; dir <= 1; dir += 2)
+                for (int dx = dir < 0 ? 0 : 1; ; dx++) {
+                    Placement p;
+                    p.start = turned;
+                    p.start.x += dir * dx;
+                    if (!fits(field, p.start)) break;
+
+                    Piece drop = p.start;
+                    for (;;) {
+                        drop.y++;
+                        if (!fits(field, drop)) { drop.y--; break; }
+                    }
+                    cellsOf(drop, p.landed);
+
+                    // resting partly above the well ends the game
+                    bool inside = true;
+                    for (auto& c : p.landed) inside &= c.y >= 0;
+                    if (inside) out.push_back(p);
+                }
+        }
+    }
+
+    // Picks where to play each piece. With a next piece given it looks one
+    // piece ahead and scores a placement by the best follow-up it leaves.
+    // Placements are scored on the pool if there is one; the choice is the
+    // same either way (ties go to the first placement found).
+    class Bot
+    {
+        Weights weights;
+        ThreadPool* pool;
+        std::vector<Placement> candidates;
+        std::vector<double> scores;
+
+        // best score over the placements of `piece` on `field`
+        double bestFollowUp(const Field& field, int piece, int linesSoFar) const
+        {
+            std::vector<Placement> next;
+            placements(field, piece, next);
+            double best = -1e30;
+            for (auto& p : next) {
+                Field after = field;
+                int lines = after.lock(p.landed, 1);
+                double s = evaluate(after, linesSoFar + lines, weights);
+                if (s > best) best = s;
+            }
+            return best;
+        }
+
+    public:
+        explicit Bot(ThreadPool* pool = nullptr, Weights weights = Weights()) : weights(weights), pool(pool) {}
+
+        // false if the piece can't be placed at all (the well is topped out)
+        bool choose(const Field& field, int piece, int nextPiece, Placement& chosen)
+        {
+            placements(field, piece, candidates);
+            if (candidates.empty()) return false;
+
+            scores.assign(candidates.size(), 0);
+            std::function<void(int)> score = [&](int i) {
+                Field after = field;
+                int lines = after.lock(candidates[i].landed, 1);
+                scores[i] = nextPiece < 0 ? evaluate(after, lines, weights) : bestFollowUp(after, nextPiece, lines);
+            };
+            if (pool) pool->forEach((int)candidates.size(), score);
+            else for (int i = 0; i < (int)candidates.size(); i++) score(i);
+
+            int best = 0;
+            for (int i = 1; i < (int)candidates.size(); i++)
+                if (scores[i] > scores[best]) best = i;
+            chosen = candidates[best];
+            return true;
+        }
+    };
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace Tetris {
+
+    const int ROWS = 20;
+    const int COLS = 10;
+
+    struct Point
+    {
+        int x, y;
+    };
+
+    // The well as one word per row: bit PAD + x is set when column x is
+    // taken, and the bits either side of the ten columns are always set, so
+    // they act as the walls. A cell test is one AND, a piece test four, and
+    // a row is full exactly when its word is all ones. The colours live in a
+    // separate plane that is only read for drawing.
+    class Field
+    {
+    public:
+        typedef uint32_t Row;
+        static const int PAD = 4; // wall bits to the left of column 0
+
+        static Row walls() { return ~(((Row(1) << COLS) - 1) << PAD); }
+        static Row full() { return ~Row(0); }
+
+    private:
+        Row rows[ROWS];
+        unsigned char colours[ROWS][COLS];
+
+        // the word for row y; above the well only the walls are there, below it is all floor
+        Row row(int y) const
+        {
+            if (y < 0) return walls();
+            if (y >= ROWS) return full();
+            return rows[y];
+        }
+
+        void removeRow(int y)
+        {
+            for (int i = y; i > 0; i--) rows[i] = rows[i - 1];
+            std::memmove(colours[1], colours[0], sizeof colours[0] * y);
+            rows[0] = walls();
+            std::memset(colours[0], 0, sizeof colours[0]);
+        }
+
+    public:
+        Field() { clear(); }
+
+        void clear()
+        {
+            for (auto& r : rows) r = walls();
+            std::memset(colours, 0, sizeof colours);
+        }
+
+        // colour of a cell, 0 when empty
+        int cell(int y, int x) const { return colours[y][x]; }
+
+        bool isFree(int y, int x) const
+        {
+            if (x < -PAD || x >= COLS + PAD) return false;
+            return (row(y) & (Row(1) << (x + PAD))) == 0;
+        }
+
+        bool fits(const Point cells[4]) const
+        {
+            for (int i = 0; i < 4; i++)
+                if (!isFree(cells[i].y, cells[i].x)) return false;
+            return true;
+        }
+
+        bool rowFull(int y) const { return rows[y] == full(); }
+
+        // the raw word of row y, walls included; any y is fine
+        Row bits(int y) const { return row(y); }
+
+        // writes a piece into the well and removes the rows it completed;
+        // only the piece's own rows can have become full, so only they are
+        // looked at. Returns the number of rows removed.
+        int lock(const Point cells[4], int colour)
+        {
+            int top = ROWS, bottom = -1;
+            for (int i = 0; i < 4; i++) {
+                const Point& c = cells[i];
+                if (c.y < 0 || c.y >= ROWS || c.x < 0 || c.x >= COLS) continue;
+                rows[c.y] |= Row(1) << (c.x + PAD);
+                colours[c.y][c.x] = (unsigned char)colour;
+                if (c.y < top) top = c.y;
+                if (c.y > bottom) bottom = c.y;
+            }
+
+            // top to bottom, so removing a row doesn't move one still to check
+            int removed = 0;
+            for (int y = top; y <= bottom; y++)
+                if (rowFull(y)) {
+                    removeRow(y);
+                    removed++;
+                }
+            return removed;
+        }
+    };
+
+}
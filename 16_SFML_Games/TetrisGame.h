@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include "TetrisAI.h"
+#include "TetrisField.h"
+#include "TetrisPiece.h"
+
+namespace Tetris {
+
+    // The seven pieces in a shuffled order, then the seven again in a new
+    // order, and so on. The shuffle is written out rather than left to
+    // std::shuffle, whose results differ between standard libraries, so a
+    // seed gives the same pieces on every platform.
+    class Bag
+    {
+        std::minstd_rand random;
+        int order[PIECE_COUNT];
+        int used;
+
+    public:
+        explicit Bag(uint32_t seed = 1) : random(seed), used(PIECE_COUNT) {}
+
+        int next()
+        {
+            if (used == PIECE_COUNT) {
+                for (int i = 0; i < PIECE_COUNT; i++) order[i] = i;
+                for (int i = PIECE_COUNT - 1; i > 0; i--)
+                    std::swap(order[i], order[random() % (i + 1)]);
+                used = 0;
+            }
+            return order[used++];
+        }
+    };
+
+    // the keys held during a tick
+    struct Input
+    {
+        bool left, right, rotateRight, rotateLeft, softDrop, bot;
+    };
+
+    // One game of Tetris with no SFML and no globals. tick() is one step of
+    // a fixed TICKS_PER_SECOND clock; everything it does depends only on the
+    // seed and the inputs, so a game can be replayed exactly.
+    class Game
+    {
+    public:
+        static const int TICKS_PER_SECOND = 60;
+
+        Field field;
+        Piece piece;
+        int next;
+        long long ticks;
+        int score, lines;
+        bool gameOver;
+        bool botPlays; // the bot places each piece as it appears
+
+        // ticks between steps down: normally, with soft drop held, and for the bot
+        int fallTicks = 18, softDropTicks = 3, botFallTicks = 1;
+
+        // holding left or right moves once, then again after dasTicks, then
+        // every arrTicks (delayed auto shift and auto repeat rate)
+        int dasTicks = 10, arrTicks = 2;
+
+        explicit Game(uint32_t seed = 1, ThreadPool* pool = nullptr) : bot(pool) { reset(seed); }
+
+        Game(const Game&) = delete;
+        Game& operator=(const Game&) = delete;
+
+        void reset(uint32_t seed, bool withBot = false)
+        {
+            field.clear();
+            bag = Bag(seed);
+            next = bag.next();
+            ticks = 0;
+            score = lines = 0;
+            gameOver = false;
+            botPlays = withBot;
+            held = Input{};
+            fallTimer = 0;
+            shiftDir = shiftTimer = 0;
+            spawn();
+        }
+
+        // colour of the piece in play, 1 to 7
+        int colour() const { return piece.type + 1; }
+
+        void tick(const Input& input)
+        {
+            if (gameOver) return;
+            ticks++;
+
+            // turns happen when a key goes down, not while it is held
+            if (input.bot && !held.bot) botPlays = !botPlays;
+            if (!botPlays) {
+                autoShift(input);
+                if (input.rotateRight && !held.rotateRight) rotate(field, piece, 1);
+                if (input.rotateLeft && !held.rotateLeft) rotate(field, piece, -1);
+            }
+            held = input;
+
+            int delay = botPlays ? botFallTicks : input.softDrop ? softDropTicks : fallTicks;
+            if (++fallTimer >= delay) {
+                fallTimer = 0;
+                fall();
+            }
+        }
+
+        // FNV-1a over everything tick() reads or writes
+        uint64_t checksum() const
+        {
+            uint64_t h = 1469598103934665603ull;
+            auto mix = [&h](long long v) {
+                for (int i = 0; i < 8; i++) { h ^= (unsigned char)(v >> (8 * i)); h *= 1099511628211ull; }
+            };
+
+            for (int y = 0; y < ROWS; y++)
+                for (int x = 0; x < COLS; x++)
+                    mix(field.cell(y, x));
+            mix(piece.type); mix(piece.rotation); mix(piece.x); mix(piece.y); mix(next);
+            mix(ticks); mix(score); mix(lines); mix(gameOver); mix(botPlays); mix(fallTimer);
+            mix(shiftDir); mix(shiftTimer);
+            return h;
+        }
+
+    private:
+        Bag bag;
+        Bot bot;
+        Input held;
+        int fallTimer;
+        int shiftDir, shiftTimer; // the side being held and for how many ticks
+
+        // the key pressed last wins; letting it go stops the repeat
+        void autoShift(const Input& input)
+        {
+            if (input.left && !held.left) shiftDir = -1;
+            else if (input.right && !held.right) shiftDir = 1;
+            else if (shiftDir != 0 && (shiftDir < 0 ? input.left : input.right)) {
+                shiftTimer++;
+                if (shiftTimer >= dasTicks && (shiftTimer - dasTicks) % arrTicks == 0) shift(shiftDir);
+                return;
+            }
+            else {
+                shiftDir = 0;
+                return;
+            }
+
+            shiftTimer = 0;
+            shift(shiftDir);
+        }
+
+        void shift(int dx)
+        {
+            Piece moved = piece;
+            moved.x += dx;
+            if (fits(field, moved)) piece = moved;
+        }
+
+        void fall()
+        {
+            Piece fallen = piece;
+            fallen.y++;
+            if (fits(field, fallen)) {
+                piece = fallen;
+                return;
+            }
+
+            Point cells[4];
+            cellsOf(piece, cells);
+            for (auto& c : cells)
+                if (c.y < 0) { gameOver = true; return; } // locked above the well
+
+            static const int lineScores[5] = { 0, 100, 300, 500, 800 };
+            int cleared = field.lock(cells, colour());
+            lines += cleared;
+            score += lineScores[cleared];
+            spawn();
+        }
+
+        void spawn()
+        {
+            piece = spawnPiece(next);
+            next = bag.next();
+            if (!fits(field, piece)) { gameOver = true; return; }
+
+            Placement move;
+            if (!botPlays) return;
+            if (bot.choose(field, piece.type, next, move)) piece = move.start;
+            else gameOver = true;
+        }
+    };
+
+}
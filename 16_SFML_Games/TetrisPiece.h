@@ -0,0 +1,146 @@
+#pragma once
+
+#include "TetrisField.h"
+
+namespace Tetris {
+
+    const int PIECE_COUNT = 7;
+    enum PieceType { I, Z, S, T, L, J, O };
+
+    // A piece in play: its type, how far it has turned (0 = spawn, 1 = right,
+    // 2 = upside down, 3 = left) and where the top left of its bounding box is.
+    struct Piece
+    {
+        int type, rotation, x, y;
+    };
+
+    // one rotation state: the cells relative to the box and, for each box
+    // row, which box columns are taken (bit c = column c)
+    struct Shape
+    {
+        Point cells[4];
+        unsigned char rows[4];
+    };
+
+    struct ShapeTable
+    {
+        Shape shapes[PIECE_COUNT][4];
+    };
+
+    // Builds every rotation state from the spawn shapes, which follow the
+    // usual guideline layout: I in a 4x4 box, O fixed in the middle of the
+    // top two rows, the rest in a 3x3 box turning about its centre.
+    constexpr ShapeTable makeShapes()
+    {
+        const Point spawnCells[PIECE_COUNT][4] = {
+            { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 } }, // I
+            { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 2, 1 } }, // Z
+            { { 1, 0 }, { 2, 0 }, { 0, 1 }, { 1, 1 } }, // S
+            { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } }, // T
+            { { 2, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } }, // L
+            { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } }, // J
+            { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } }, // O
+        };
+        const int boxSize[PIECE_COUNT] = { 4, 3, 3, 3, 3, 3, 0 }; // 0: doesn't turn
+
+        ShapeTable table{};
+        for (int n = 0; n < PIECE_COUNT; n++)
+            for (int r = 0; r < 4; r++) {
+                Shape& shape = table.shapes[n][r];
+                for (int i = 0; i < 4; i++) {
+                    Point c = r == 0 ? spawnCells[n][i] : table.shapes[n][r - 1].cells[i];
+                    if (r > 0 && boxSize[n] > 0) {
+                        // a quarter turn clockwise, y pointing down
+                        int x = boxSize[n] - 1 - c.y;
+                        c.y = c.x;
+                        c.x = x;
+                    }
+                    shape.cells[i] = c;
+                    shape.rows[c.y] |= (unsigned char)(1 << c.x);
+                }
+            }
+        return table;
+    }
+
+    constexpr ShapeTable shapeTable = makeShapes();
+
+    // Wall kicks: the offsets tried, in order, when turning from a rotation
+    // state, for a clockwise [0] and anticlockwise [1] turn. Written with y
+    // pointing up, as in the published guideline tables. The first test is
+    // always no offset; O uses the common table and never needs more.
+    constexpr Point commonKicks[4][2][5] = {
+        { { { 0, 0 }, { -1, 0 }, { -1, 1 }, { 0, -2 }, { -1, -2 } },   // 0 -> R
+          { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, -2 }, { 1, -2 } } },    // 0 -> L
+        { { { 0, 0 }, { 1, 0 }, { 1, -1 }, { 0, 2 }, { 1, 2 } },       // R -> 2
+          { { 0, 0 }, { 1, 0 }, { 1, -1 }, { 0, 2 }, { 1, 2 } } },     // R -> 0
+        { { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, -2 }, { 1, -2 } },      // 2 -> L
+          { { 0, 0 }, { -1, 0 }, { -1, 1 }, { 0, -2 }, { -1, -2 } } }, // 2 -> R
+        { { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0, 2 }, { -1, 2 } },    // L -> 0
+          { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0, 2 }, { -1, 2 } } },  // L -> 2
+    };
+
+    constexpr Point iKicks[4][2][5] = {
+        { { { 0, 0 }, { -2, 0 }, { 1, 0 }, { -2, -1 }, { 1, 2 } },     // 0 -> R
+          { { 0, 0 }, { -1, 0 }, { 2, 0 }, { -1, 2 }, { 2, -1 } } },   // 0 -> L
+        { { { 0, 0 }, { -1, 0 }, { 2, 0 }, { -1, 2 }, { 2, -1 } },     // R -> 2
+          { { 0, 0 }, { 2, 0 }, { -1, 0 }, { 2, 1 }, { -1, -2 } } },   // R -> 0
+        { { { 0, 0 }, { 2, 0 }, { -1, 0 }, { 2, 1 }, { -1, -2 } },     // 2 -> L
+          { { 0, 0 }, { 1, 0 }, { -2, 0 }, { 1, -2 }, { -2, 1 } } },   // 2 -> R
+        { { { 0, 0 }, { 1, 0 }, { -2, 0 }, { 1, -2 }, { -2, 1 } },     // L -> 0
+          { { 0, 0 }, { -2, 0 }, { 1, 0 }, { -2, -1 }, { 1, 2 } } },   // L -> 2
+    };
+
+    const int KICK_TESTS = 5;
+
+    inline const Shape& shapeOf(const Piece& p) { return shapeTable.shapes[p.type][p.rotation]; }
+
+    // offset of kick test k when turning p clockwise (dir 1) or anticlockwise (dir -1), y down
+    inline Point kick(const Piece& p, int dir, int k)
+    {
+        const Point& k0 = (p.type == I ? iKicks : commonKicks)[p.rotation][dir > 0 ? 0 : 1][k];
+        return Point{ k0.x, -k0.y };
+    }
+
+    // a new piece at the top of the well, centred as the guideline does
+    inline Piece spawnPiece(int type)
+    {
+        return Piece{ type, 0, 3, 0 };
+    }
+
+    // the cells of a piece in well coordinates
+    inline void cellsOf(const Piece& p, Point cells[4])
+    {
+        const Shape& shape = shapeOf(p);
+        for (int i = 0; i < 4; i++) {
+            cells[i].x = p.x + shape.cells[i].x;
+            cells[i].y = p.y + shape.cells[i].y;
+        }
+    }
+
+    // one AND per row of the box against the well's row words
+    inline bool fits(const Field& field, const Piece& p)
+    {
+        if (p.x < -Field::PAD || p.x > COLS) return false;
+        const Shape& shape = shapeOf(p);
+        for (int r = 0; r < 4; r++)
+            if (field.bits(p.y + r) & (Field::Row(shape.rows[r]) << (p.x + Field::PAD)))
+                return false;
+        return true;
+    }
+
+    // turns p a quarter clockwise (dir 1) or anticlockwise (dir -1), trying
+    // each wall kick in turn; leaves p alone and returns false if none fits
+    inline bool rotate(const Field& field, Piece& p, int dir)
+    {
+        for (int k = 0; k < KICK_TESTS; k++) {
+            Point offset = kick(p, dir, k);
+            Piece turned{ p.type, (p.rotation + (dir > 0 ? 1 : 3)) % 4, p.x + offset.x, p.y + offset.y };
+            if (fits(field, turned)) {
+                p = turned;
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "TetrisGame.h"
+
+namespace Tetris {
+
+    // A recorded game: the seed, whether the bot started out playing, and
+    // every tick at which the held keys changed. On disk it is plain text:
+    //
+    //   tetris replay
+    //   seed 1234
+    //   bot 0
+    //   0 -            then one line per change: ticks since the previous
+    //   41 L           change and the keys held from then on, '-' for none
+    //   3 -            (L left, R right, X turn right, Z turn left,
+    //   20 XD          D soft drop, B bot)
+    //   end 5321 1200 12 9f3c1a2b44d0e817
+    //
+    // The end line is the tick count, score, lines and checksum the game
+    // finished with, so playing the replay back can check it gets there.
+    // Keys are held for many ticks at a time, so a game of several minutes
+    // is a few hundred short lines.
+    struct Replay
+    {
+        struct Change
+        {
+            long long tick; // the first tick with these keys
+            unsigned keys;
+        };
+
+        uint32_t seed = 1;
+        bool bot = false;
+        std::vector<Change> changes;
+        long long ticks = 0;
+        int score = 0, lines = 0;
+        uint64_t checksum = 0;
+    };
+
+    const char REPLAY_KEYS[] = "LRXZDB";
+
+    inline unsigned packInput(const Input& input)
+    {
+        return (input.left ? 1u : 0) | (input.right ? 2u : 0) | (input.rotateRight ? 4u : 0) |
+               (input.rotateLeft ? 8u : 0) | (input.softDrop ? 16u : 0) | (input.bot ? 32u : 0);
+    }
+
+    inline Input unpackInput(unsigned keys)
+    {
+        return Input{ (keys & 1) != 0, (keys & 2) != 0, (keys & 4) != 0, (keys & 8) != 0, (keys & 16) != 0, (keys & 32) != 0 };
+    }
+
+    // Collects a replay while a game is played: record() the input of every
+    // tick before passing it to the game, and finish() once it is over.
+    class Recorder
+    {
+        Replay replay;
+        long long tick = 0;
+        unsigned last = ~0u;
+
+    public:
+        explicit Recorder(uint32_t seed = 1, bool bot = false)
+        {
+            replay.seed = seed;
+            replay.bot = bot;
+        }
+
+        void record(const Input& input)
+        {
+            unsigned keys = packInput(input);
+            if (keys != last) replay.changes.push_back(Replay::Change{ tick, keys });
+            last = keys;
+            tick++;
+        }
+
+        const Replay& finish(const Game& game)
+        {
+            replay.ticks = game.ticks;
+            replay.score = game.score;
+            replay.lines = game.lines;
+            replay.checksum = game.checksum();
+            return replay;
+        }
+    };
+
+    inline void writeReplay(std::ostream& out, const Replay& replay)
+    {
+        out << "tetris replay\n";
+        out << "seed " << replay.seed << "\n";
+        out << "bot " << (replay.bot ? 1 : 0) << "\n";
+
+        long long previous = 0;
+        for (auto& c : replay.changes) {
+            out << c.tick - previous << " ";
+            if (c.keys == 0) out << "-";
+            for (int k = 0; REPLAY_KEYS[k]; k++)
+                if (c.keys & (1u << k)) out << REPLAY_KEYS[k];
+            out << "\n";
+            previous = c.tick;
+        }
+
+        out << "end " << replay.ticks << " " << replay.score << " " << replay.lines << " "
+            << std::hex << replay.checksum << std::dec << "\n";
+    }
+
+    // returns false, leaving `replay` untouched, if the text is not a replay
+    inline bool readReplay(std::istream& in, Replay& replay)
+    {
+        Replay read;
+        std::string line;
+        if (!std::getline(in, line) || line.compare(0, 13, "tetris replay") != 0) return false;
+
+        bool ended = false;
+        long long tick = 0;
+        while (!ended && std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            std::istringstream words(line);
+            std::string first, keys;
+            words >> first;
+            if (first == "seed") { if (!(words >> read.seed)) return false; }
+            else if (first == "bot") { if (!(words >> read.bot)) return false; }
+            else if (first == "end") {
+                if (!(words >> read.ticks >> read.score >> read.lines >> std::hex >> read.checksum)) return false;
+                ended = true;
+            }
+            else {
+                std::istringstream number(first);
+                long long delta;
+                if (!(number >> delta) || delta < 0 || !(words >> keys)) return false;
+                unsigned packed = 0;
+                for (char c : keys)
+                    for (int k = 0; REPLAY_KEYS[k]; k++)
+                        if (c == REPLAY_KEYS[k]) packed |= 1u << k;
+                tick += delta;
+                read.changes.push_back(Replay::Change{ tick, packed });
+            }
+        }
+
+        if (!ended) return false;
+        replay = read;
+        return true;
+    }
+
+    inline bool saveReplay(const std::string& path, const Replay& replay)
+    {
+        std::ofstream out(path);
+        writeReplay(out, replay);
+        return bool(out);
+    }
+
+    inline bool loadReplay(const std::string& path, Replay& replay)
+    {
+        std::ifstream in(path);
+        return in && readReplay(in, replay);
+    }
+
+    // Plays a replay back into `game` without a window, as fast as it will
+    // go. True if the game ends on the recorded tick, score, lines and
+    // checksum.
+    inline bool playReplay(const Replay& replay, Game& game)
+    {
+        game.reset(replay.seed, replay.bot);
+        size_t change = 0;
+        unsigned keys = 0;
+        for (long long t = 0; t < replay.ticks && !game.gameOver; t++) {
+            while (change < replay.changes.size() && replay.changes[change].tick <= t)
+                keys = replay.changes[change++].keys;
+            game.tick(unpackInput(keys));
+        }
+        return game.ticks == replay.ticks && game.score == replay.score &&
+               game.lines == replay.lines && game.checksum() == replay.checksum;
+    }
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+
+// Turns wall clock time into whole fixed-length ticks, so a game steps at
+// the same rate whatever the frame rate. The loop sleeps until nextTick(),
+// then runs due() ticks; tick k is due exactly k periods after start(), so
+// rounding never makes the clock drift. If the loop falls more than
+// maxCatchUp ticks behind (the window was dragged, the process stalled) the
+// missed ticks are dropped instead of being run all at once.
+class TickScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit TickScheduler(int ticksPerSecond, int maxCatchUp = 5)
+        : ticksPerSecond(ticksPerSecond), maxCatchUp(maxCatchUp), count(0) {
+        start(Clock::now());
+    }
+
+    void start(Clock::time_point now) {
+        origin = now;
+        count = 0;
+    }
+
+    // the number of ticks to run now; the loop must run them all
+    int due(Clock::time_point now) {
+        int n = 0;
+        while (now >= tickTime(count + 1)) {
+            if (n == maxCatchUp) {
+                start(now); // too far behind: carry on from here
+                break;
+            }
+            count++;
+            n++;
+        }
+        return n;
+    }
+
+    // when the next tick is due
+    Clock::time_point nextTick() const { return tickTime(count + 1); }
+
+private:
+    int ticksPerSecond, maxCatchUp;
+    Clock::time_point origin;
+    long long count; // ticks handed out since origin
+
+    Clock::time_point tickTime(long long k) const {
+        return origin + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(k * 1000000000LL / ticksPerSecond));
+    }
+};
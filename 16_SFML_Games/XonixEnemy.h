@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdlib>
+
+// Walks the tiles between pixel `from` and `from + step` along one axis,
+// stepping one tile boundary at a time (a one dimensional DDA), so a move
+// longer than a tile cannot jump over a wall. `fixedTile` is the row for a
+// horizontal move and the column for a vertical one.
+// Returns false at the first wall after the start tile; new wall tiles on
+// the way set `crossedNewWall`.
+template<class Board>
+bool sweepAxis(Board& grid, int from, int step, int fixedTile, bool horizontal, bool& crossedNewWall)
+{
+    int ts = grid.tileSize();
+    int to = from + step;
+    int start = from / ts, last = to >= 0 ? to / ts : -1; // anything left of / above the board is off it
+    int dir = step < 0 ? -1 : 1;
+
+    for (int tile = start; ; tile += dir) {
+        int y = horizontal ? fixedTile : tile;
+        int x = horizontal ? tile : fixedTile;
+        if (y < 0 || y >= grid.height() || x < 0 || x >= grid.width()) return false;
+        if (tile != start && grid.isWall(y, x)) return false;
+        if (grid.isNewWall(y, x)) crossedNewWall = true;
+        if (tile == last) return true;
+    }
+}
+
+struct Enemy
+{
+    int x, y, dx, dy;        // pixels, pixels per move
+    bool crossedNewWall;     // passed over a new wall during the last move
+
+    Enemy(int x = 300, int y = 300, int maxSpeed = 4) : x(x), y(y), crossedNewWall(false)
+    {
+        dx = maxSpeed - rand() % (2 * maxSpeed);
+        dy = maxSpeed - rand() % (2 * maxSpeed);
+    }
+
+    // same, drawing the velocity from a generator of its own instead of rand()
+    template<class Random>
+    Enemy(int x, int y, int maxSpeed, Random& random) : x(x), y(y), crossedNewWall(false)
+    {
+        dx = maxSpeed - (int)(random() % (2 * maxSpeed));
+        dy = maxSpeed - (int)(random() % (2 * maxSpeed));
+    }
+
+    // moves along x then along y, bouncing back off walls as before
+    template<class Board>
+    void move(Board& grid)
+    {
+        int ts = grid.tileSize();
+        crossedNewWall = false;
+
+        if (sweepAxis(grid, x, dx, y / ts, true, crossedNewWall)) x += dx;
+        else dx = -dx;
+
+        if (sweepAxis(grid, y, dy, x / ts, false, crossedNewWall)) y += dy;
+        else dy = -dy;
+    }
+
+    template<class Board>
+    bool touchesNewWall(Board& grid) const
+    {
+        return crossedNewWall || grid.pointInNewWall(y, x);
+    }
+};
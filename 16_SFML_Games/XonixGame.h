@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Grid.h"
+#include "Player.h"
+#include "XonixEnemy.h"
+
+struct XonixInput {
+    bool left, right, up, down;
+};
+
+// One game of Xonix with no SFML and no globals, so several can run side by
+// side (one per thread for bots and benchmarks). tick() is one frame of the
+// original game loop.
+class XonixGame {
+public:
+    Grid grid;
+    Player player;
+    std::vector<Enemy> enemies;
+    bool gameOver;
+    int levelsCompleted;
+    long long ticks;
+
+    float targetPercent;   // captured share of the board that completes a level
+    int playerMoveTicks;   // the player steps one tile every this many ticks
+
+    XonixGame(int enemyCount = 4, uint32_t seed = 1, int height = 25, int width = 40, int tileSize = 18)
+        : grid(height, width, tileSize), player(width, height), gameOver(false), levelsCompleted(0), ticks(0),
+          targetPercent(75), playerMoveTicks(4), random(seed), drawing(false) {
+        // enemies start at 300, 300 on the classic board, and at the same spot on others
+        for (int i = 0; i < enemyCount; i++)
+            enemies.push_back(Enemy(width * tileSize * 5 / 12, height * tileSize * 2 / 3, 4, random));
+    }
+
+    XonixGame(const XonixGame&) = delete;
+    XonixGame& operator=(const XonixGame&) = delete;
+
+    // a new board; the enemies carry on where they are
+    void reset() {
+        grid.clear();
+        player.reset();
+        gameOver = false;
+        drawing = false;
+    }
+
+    void tick(const XonixInput& input) {
+        if (gameOver) return;
+        ticks++;
+
+        if (input.left) player.goLeft();
+        if (input.right) player.goRight();
+        if (input.up) player.goUp();
+        if (input.down) player.goDown();
+
+        bool playerTouchedNewWall = false;
+        if (ticks % playerMoveTicks == 0) {
+            player.move();
+            playerTouchedNewWall = grid.cellIsNewWall(player.y, player.x);
+            drawing |= grid.isEmpty(player.y, player.x);
+            grid.newWall(player.y, player.x);
+        }
+
+        for (auto& e : enemies) e.move(grid);
+
+        playerCompletesLoop();
+
+        // the grid keeps its wall count up to date, so this is O(1) per tick
+        if (grid.levelComplete(targetPercent)) {
+            levelsCompleted++;
+            reset();
+            return;
+        }
+
+        gameOver = enemyTouchesNewWall() || playerTouchedNewWall;
+    }
+
+    // FNV-1a over everything tick() reads or writes
+    uint64_t checksum() const {
+        uint64_t h = 1469598103934665603ull;
+        auto mix = [&h](long long v) {
+            for (int i = 0; i < 8; i++) { h ^= (unsigned char)(v >> (8 * i)); h *= 1099511628211ull; }
+        };
+
+        for (int y = 0; y < grid.height(); y++)
+            for (int x = 0; x < grid.width(); x++)
+                mix(grid.cell(y, x));
+        mix(player.x); mix(player.y); mix(player.dx); mix(player.dy);
+        for (auto& e : enemies) { mix(e.x); mix(e.y); mix(e.dx); mix(e.dy); }
+        mix(gameOver); mix(levelsCompleted); mix(ticks); mix(drawing);
+        return h;
+    }
+
+private:
+    std::minstd_rand random;
+
+    bool enemyTouchesNewWall() {
+        for (auto& e : enemies)
+            if (e.touchesNewWall(grid)) return true;
+        return false;
+    }
+
+    // closing a loop captures; standing on the wall without having drawn
+    // anything would capture nothing, so the fill is skipped then
+    void playerCompletesLoop() {
+        if (!grid.isWall(player.y, player.x)) return;
+
+        player.stop();
+        if (!drawing) return;
+        drawing = false;
+
+        seeds.clear();
+        for (auto& e : enemies)
+            seeds.push_back(Seed{ e.y / grid.tileSize(), e.x / grid.tileSize() });
+        grid.markConnectedCellsNotToBeFilled(seeds);
+        grid.fillEmptyCells();
+    }
+
+    std::vector<Seed> seeds;
+    bool drawing; // the player has left new wall since the last capture
+};
@@ -1,9 +1,12 @@
 #include <SFML/Graphics.hpp>
 #include <time.h>
+#include <vector>
+#include "ArkanoidBalls.h"
+#include "ArkanoidCollision.h"
+#include "ArkanoidLevel.h"
 using namespace sf;
 
-// data clump for a block
-struct Block { float x; float y; bool alive; };
+using Arkanoid::Block;
 
 // load textures from disk
 void loadTextures(Texture &blockTex, Texture &bgTex, Texture &ballTex, Texture &paddleTex)
@@ -25,19 +28,13 @@ void setupSprites(Sprite &sBackground, Sprite &sBall, Sprite &sPaddle,
     sPaddle.setPosition(paddleStartX, paddleStartY);
 }
 
-// create a grid of block data entries
-void createBlocksData(Block blocks[], int &blockCount,
-                      int cols, int rows, int spacingX, int spacingY)
+// the level file, or the classic wall of blocks when it can't be read
+Arkanoid::Level loadBlocks(const char *path, int cols, int rows, int spacingX, int spacingY)
 {
-    blockCount = 0;
-    for (int i = 1; i <= cols; i++)
-        for (int j = 1; j <= rows; j++)
-        {
-            blocks[blockCount].x = i * spacingX;
-            blocks[blockCount].y = j * spacingY;
-            blocks[blockCount].alive = true;
-            blockCount++;
-        }
+    Arkanoid::Level level;
+    if (!Arkanoid::loadLevel(path, level))
+        level = Arkanoid::latticeLevel(cols, rows, spacingX, spacingY, spacingX, spacingY);
+    return level;
 }
 
 void handleInput(Sprite &sPaddle, float paddleMoveSpeed)
@@ -48,72 +45,69 @@ void handleInput(Sprite &sPaddle, float paddleMoveSpeed)
         sPaddle.move(-paddleMoveSpeed, 0);
 }
 
-// check collisions between a collision rectangle and all block data
-// if a block is hit, mark it not alive and invert velocity
-void checkBlockCollisions(Block blocks[], int blockCount, const FloatRect &collisionRect, float blockW, float blockH, float &vel)
+// the paddle as the balls' collision rects see it: a ball bounces when its
+// sprite touches the paddle, so the paddle grows by the margin between the two
+Arkanoid::Rect paddleRect(const Sprite &sPaddle,
+                          float ballCollOffsetX, float ballCollOffsetY, float ballCollW, float ballCollH,
+                          float ballDrawW, float ballDrawH)
+{
+    FloatRect b = sPaddle.getGlobalBounds();
+    return Arkanoid::Rect{ b.left - ballCollOffsetX, b.top - ballCollOffsetY,
+                           b.width + ballDrawW - ballCollW, b.height + ballDrawH - ballCollH };
+}
+
+// one textured quad per live block, drawn in a single call; the quads only
+// change when a block dies, and then just by moving the last quad into the gap
+class BlockBatch
 {
-    for (int i = 0; i < blockCount; i++)
+    Arkanoid::AliveBlocks alive;
+    VertexArray quads;
+
+public:
+    BlockBatch(const std::vector<Block> &blocks, float blockW, float blockH)
+        : alive(blocks), quads(Quads, alive.size() * 4)
     {
-        if (!blocks[i].alive) continue;
-        FloatRect blockRect(blocks[i].x, blocks[i].y, blockW, blockH);
-        if (collisionRect.intersects(blockRect))
+        for (int s = 0; s < alive.size(); s++)
         {
-            blocks[i].alive = false;
-            vel = -vel;
+            const Block &b = blocks[alive[s]];
+            Vertex *quad = &quads[s * 4];
+            quad[0] = Vertex(Vector2f(b.x, b.y), Vector2f(0, 0));
+            quad[1] = Vertex(Vector2f(b.x + blockW, b.y), Vector2f(blockW, 0));
+            quad[2] = Vertex(Vector2f(b.x + blockW, b.y + blockH), Vector2f(blockW, blockH));
+            quad[3] = Vertex(Vector2f(b.x, b.y + blockH), Vector2f(0, blockH));
         }
     }
-}
 
-// move ball and detect collisions with blocks and screen bounds
-void updatePhysics(float &ballPosX, float &ballPosY, float &ballVelX, float &ballVelY,
-                   Block blocks[], int blockCount,
-                   float blockW, float blockH,
-                   float ballCollOffsetX, float ballCollOffsetY, float ballCollW, float ballCollH,
-                   int windowWidth, int windowHeight)
-{
-    // Horizontal movement step
-    ballPosX += ballVelX; // move ball horizontally
-    FloatRect ballCollisionRectH(ballPosX + ballCollOffsetX, ballPosY + ballCollOffsetY, ballCollW, ballCollH);
-    checkBlockCollisions(blocks, blockCount, ballCollisionRectH, blockW, blockH, ballVelX);
-
-    // Vertical movement step
-    ballPosY += ballVelY; // move ball vertically
-    FloatRect ballCollisionRectV(ballPosX + ballCollOffsetX, ballPosY + ballCollOffsetY, ballCollW, ballCollH);
-    checkBlockCollisions(blocks, blockCount, ballCollisionRectV, blockW, blockH, ballVelY);
-
-    // screen boundary checks
-    if (ballPosX < 0 || ballPosX > windowWidth)
-        ballVelX = -ballVelX; // bounce on left/right edges
-    if (ballPosY < 0 || ballPosY > windowHeight)
-        ballVelY = -ballVelY; // bounce on top/bottom edges
-}
+    void remove(int block)
+    {
+        int s = alive.remove(block);
+        if (s < 0) return;
+        int last = alive.size();
+        for (int k = 0; k < 4; k++)
+            quads[s * 4 + k] = quads[last * 4 + k];
+        quads.resize(last * 4);
+    }
 
-void handlePaddleCollision(float &ballPosX, float &ballPosY, float &ballVelY,
-                           const Sprite &sPaddle,
-                           float ballDrawW, float ballDrawH,
-                           int bounceRandRange, int bounceRandMin)
-{
-    FloatRect paddleBounds = sPaddle.getGlobalBounds();
-    FloatRect ballDrawRect(ballPosX, ballPosY, ballDrawW, ballDrawH);
-    if (ballDrawRect.intersects(paddleBounds))
-        ballVelY = -(rand() % bounceRandRange + bounceRandMin);
-}
+    void draw(RenderWindow &app, const Texture &blockTex)
+    {
+        app.draw(quads, RenderStates(&blockTex));
+    }
+};
 
 // Draw the current frame
 void drawFrame(RenderWindow &app, Sprite &sBackground, Sprite &sBall, Sprite &sPaddle,
-               Sprite &blockSpriteTemplate, Block blocks[], int blockCount)
+               const Arkanoid::BallSet &balls, BlockBatch &blockBatch, const Texture &blockTex)
 {
     app.clear();
     app.draw(sBackground);
-    app.draw(sBall);
-    app.draw(sPaddle);
-
-    for (int i = 0; i < blockCount; i++)
+    for (int i = 0; i < balls.size(); i++)
     {
-        if (!blocks[i].alive) continue;
-        blockSpriteTemplate.setPosition(blocks[i].x, blocks[i].y);
-        app.draw(blockSpriteTemplate);
+        sBall.setPosition(balls.x[i], balls.y[i]);
+        app.draw(sBall);
     }
+    app.draw(sPaddle);
+
+    blockBatch.draw(app, blockTex);
 
     app.display();
 }
@@ -131,7 +125,7 @@ int arkanoid()
     const int BLOCK_ROWS = 10;
     const int BLOCK_SPACING_X = 43;
     const int BLOCK_SPACING_Y = 20;
-    const int MAX_BLOCKS = 1000;
+    const char *LEVEL_FILE = "levels/arkanoid/level1.txt";
 
     const float PADDLE_START_X = 300.f;
     const float PADDLE_START_Y = 440.f;
@@ -150,6 +144,9 @@ int arkanoid()
     const float BALL_DRAW_WIDTH = 12.f;
     const float BALL_DRAW_HEIGHT = 12.f;
 
+    // space splits every ball in two, up to this many
+    const int MAX_BALLS = 64;
+
     // bounce randomization
     const int BOUNCE_RAND_RANGE = 5;
     const int BOUNCE_RAND_MIN = 2;
@@ -165,19 +162,21 @@ int arkanoid()
     Sprite sBackground, sBall, sPaddle;
     setupSprites(sBackground, sBall, sPaddle, t2, t3, t4, PADDLE_START_X, PADDLE_START_Y);
 
-    // Single sprite template for drawing blocks
-    Sprite blockSpriteTemplate(t1);
+    // block size comes from its texture
     Vector2u blockTexSize = t1.getSize();
     float blockWidth = static_cast<float>(blockTexSize.x);
     float blockHeight = static_cast<float>(blockTexSize.y);
 
-    // Block data array
-    Block blocksData[MAX_BLOCKS];
-    int blockCount = 0; // number of blocks created
-    createBlocksData(blocksData, blockCount, BLOCK_COLUMNS, BLOCK_ROWS, BLOCK_SPACING_X, BLOCK_SPACING_Y);
+    // Blocks from the level file, indexed by lattice cell for collisions
+    Arkanoid::Level level = loadBlocks(LEVEL_FILE, BLOCK_COLUMNS, BLOCK_ROWS, BLOCK_SPACING_X, BLOCK_SPACING_Y);
+    std::vector<Block> &blocks = level.blocks;
+    Arkanoid::BlockIndex blockIndex(blocks, blockWidth, blockHeight, level.spacingX, level.spacingY);
+    BlockBatch blockBatch(blocks, blockWidth, blockHeight);
 
-    float ballVelX = BALL_VELOCITY_X, ballVelY = BALL_VELOCITY_Y; // ball velocity x and y
-    float ballPosX = BALL_START_X, ballPosY = BALL_START_Y; // ball position
+    // the balls, stepped together; the game starts with one
+    Arkanoid::BallSet balls(BALL_COLL_OFFSET_X, BALL_COLL_OFFSET_Y, BALL_COLL_WIDTH, BALL_COLL_HEIGHT);
+    balls.add(BALL_START_X, BALL_START_Y, BALL_VELOCITY_X, BALL_VELOCITY_Y);
+    auto bounceSpeed = [&]() { return -float(rand() % BOUNCE_RAND_RANGE + BOUNCE_RAND_MIN); };
 
     while (app.isOpen()) // main game loop runs until window is closed
     {
@@ -186,27 +185,23 @@ int arkanoid()
         {
             if (e.type == Event::Closed)
                 app.close(); // exit
-        }
 
-        // Update movement and block collisions
-        updatePhysics(ballPosX, ballPosY, ballVelX, ballVelY,
-                      blocksData, blockCount,
-                      blockWidth, blockHeight,
-                      BALL_COLL_OFFSET_X, BALL_COLL_OFFSET_Y, BALL_COLL_WIDTH, BALL_COLL_HEIGHT,
-                      WINDOW_WIDTH, WINDOW_HEIGHT);
+            if (e.type == Event::KeyPressed && e.key.code == Keyboard::Space)
+                balls.split(MAX_BALLS);
+        }
 
         // player input 
         handleInput(sPaddle, PADDLE_MOVE_SPEED);
 
-        // Handle ball-paddle collision
-        handlePaddleCollision(ballPosX, ballPosY, ballVelY, sPaddle,
-                              BALL_DRAW_WIDTH, BALL_DRAW_HEIGHT,
-                              BOUNCE_RAND_RANGE, BOUNCE_RAND_MIN);
-
-        sBall.setPosition(ballPosX, ballPosY); // update sprite position
+        // Update movement and collisions with blocks and the paddle; swept,
+        // so a fast ball can't pass through a block between two frames
+        Arkanoid::Rect paddle = paddleRect(sPaddle, BALL_COLL_OFFSET_X, BALL_COLL_OFFSET_Y, BALL_COLL_WIDTH, BALL_COLL_HEIGHT,
+                                           BALL_DRAW_WIDTH, BALL_DRAW_HEIGHT);
+        for (int b : balls.updateSwept(blocks, blockIndex, WINDOW_WIDTH, WINDOW_HEIGHT, paddle, bounceSpeed))
+            blockBatch.remove(b);
 
         // draw everything
-        drawFrame(app, sBackground, sBall, sPaddle, blockSpriteTemplate, blocksData, blockCount);
+        drawFrame(app, sBackground, sBall, sPaddle, balls, blockBatch, t1);
     }
 
     return 0;
@@ -1,5 +1,9 @@
 #include "gtest/gtest.h"
+#include "ArkanoidBalls.h"
 #include "ArkanoidCollision.h"
+#include "ArkanoidLevel.h"
+#include <cstdlib>
+#include <sstream>
 
 using namespace Arkanoid;
 
@@ -63,4 +67,461 @@ TEST(ArkanoidCollision, UpdatePhysicsSeparateCollisions) {
     EXPECT_FALSE(blocks[1].alive);
     EXPECT_EQ(-10.f, velocityX);
     EXPECT_EQ(-10.f, velocityY);
-}
\ No newline at end of file
+}
+
+// the blocks of a lattice like the game's, cols x rows at 43 x 20 spacing
+std::vector<Block> latticeBlocks(int cols, int rows) {
+    return latticeLevel(cols, rows, 43.f, 20.f, 43.f, 20.f).blocks;
+}
+
+// the index finds exactly the blocks the full scan finds, in any layout
+TEST(ArkanoidCollision, BlockIndexMatchesFullScan) {
+    srand(4);
+    for (int level = 0; level < 20; level++) {
+        std::vector<Block> blocks;
+        if (level % 2 == 0)
+            blocks = latticeBlocks(5 + rand() % 30, 5 + rand() % 30);
+        else
+            for (int i = 0; i < 300; i++)
+                blocks.push_back(Block{ float(rand() % 800) - 100, float(rand() % 600) / 3, true });
+        BlockIndex index(blocks, 42.f, 20.f, 43.f, 20.f);
+        std::vector<Block> indexed = blocks;
+
+        for (int q = 0; q < 500; q++) {
+            Rect r{ float(rand() % 1400) - 200, float(rand() % 900) - 200, float(1 + rand() % 60), float(1 + rand() % 60) };
+            float velScan = 3.f, velIndex = 3.f;
+            checkBlockCollisions(blocks, r, 42.f, 20.f, velScan);
+            checkBlockCollisions(indexed, index, r, velIndex);
+            ASSERT_EQ(velScan, velIndex);
+        }
+        for (size_t i = 0; i < blocks.size(); i++)
+            ASSERT_EQ(blocks[i].alive, indexed[i].alive);
+    }
+}
+
+TEST(ArkanoidCollision, BlockIndexOfNoBlocksFindsNothing) {
+    std::vector<Block> blocks;
+    BlockIndex index(blocks, 42.f, 20.f, 43.f, 20.f);
+    float vel = 5.f;
+
+    checkBlockCollisions(blocks, index, Rect{ 0.f, 0.f, 500.f, 500.f }, vel);
+
+    EXPECT_FLOAT_EQ(5.f, vel);
+}
+
+// a ball bouncing for a while through an indexed level plays out as before
+TEST(ArkanoidCollision, UpdatePhysicsWithIndexMatchesFullScan) {
+    std::vector<Block> scanned = latticeBlocks(10, 10), indexed = scanned;
+    BlockIndex index(indexed, 42.f, 20.f, 43.f, 20.f);
+
+    float ax = 300.f, ay = 300.f, avx = 6.f, avy = -5.f;
+    float bx = ax, by = ay, bvx = avx, bvy = avy;
+    for (int t = 0; t < 2000; t++) {
+        updatePhysics(ax, ay, avx, avy, scanned, 42.f, 20.f, 3.f, 3.f, 6.f, 6.f, 520, 450);
+        updatePhysics(bx, by, bvx, bvy, indexed, index, 3.f, 3.f, 6.f, 6.f, 520, 450);
+        ASSERT_EQ(ax, bx);
+        ASSERT_EQ(ay, by);
+        ASSERT_EQ(avx, bvx);
+        ASSERT_EQ(avy, bvy);
+    }
+
+    int alive = 0;
+    for (size_t i = 0; i < scanned.size(); i++) {
+        EXPECT_EQ(scanned[i].alive, indexed[i].alive);
+        alive += scanned[i].alive;
+    }
+    EXPECT_LT(alive, 100);
+}
+
+// one ball in a BallSet follows the same path as updatePhysics
+TEST(ArkanoidBalls, SingleBallMatchesUpdatePhysics) {
+    std::vector<Block> scanned = latticeBlocks(10, 10), batched = scanned;
+    BlockIndex index(batched, 42.f, 20.f, 43.f, 20.f);
+    BallSet balls(3.f, 3.f, 6.f, 6.f);
+    balls.add(300.f, 300.f, 6.f, -5.f);
+
+    float x = 300.f, y = 300.f, vx = 6.f, vy = -5.f;
+    for (int t = 0; t < 2000; t++) {
+        updatePhysics(x, y, vx, vy, scanned, 42.f, 20.f, 3.f, 3.f, 6.f, 6.f, 520, 450);
+        balls.update(batched, index, 520, 450);
+        ASSERT_EQ(x, balls.x[0]);
+        ASSERT_EQ(y, balls.y[0]);
+        ASSERT_EQ(vx, balls.vx[0]);
+        ASSERT_EQ(vy, balls.vy[0]);
+    }
+    for (size_t i = 0; i < scanned.size(); i++)
+        EXPECT_EQ(scanned[i].alive, batched[i].alive);
+}
+
+// two balls reaching the same block in the same tick both bounce off it
+TEST(ArkanoidBalls, SameBlockSameTickBouncesBoth) {
+    std::vector<Block> blocks;
+    blocks.push_back(Block{ 100.f, 100.f, true });
+    BlockIndex index(blocks, 16.f, 8.f, 43.f, 20.f);
+    BallSet balls(0.f, 0.f, 6.f, 6.f);
+    balls.add(90.f, 100.f, 5.f, 0.f);   // from the left
+    balls.add(120.f, 101.f, -5.f, 0.f); // from the right
+
+    std::vector<int> killed = balls.update(blocks, index, 800, 600);
+
+    EXPECT_FALSE(blocks[0].alive);
+    EXPECT_EQ(std::vector<int>{ 0 }, killed);
+    EXPECT_EQ(-5.f, balls.vx[0]);
+    EXPECT_EQ(5.f, balls.vx[1]);
+}
+
+// the order the balls are stored in does not change what happens
+TEST(ArkanoidBalls, OutcomeDoesNotDependOnBallOrder) {
+    std::vector<Block> forward = latticeBlocks(10, 10), backward = forward;
+    BlockIndex index(forward, 42.f, 20.f, 43.f, 20.f);
+    BallSet a(3.f, 3.f, 6.f, 6.f), b(3.f, 3.f, 6.f, 6.f);
+
+    srand(8);
+    const int n = 300;
+    for (int i = 0; i < n; i++)
+        a.add(float(rand() % 520), float(rand() % 450), float(rand() % 13 - 6), float(rand() % 13 - 6));
+    for (int i = n - 1; i >= 0; i--)
+        b.add(a.x[i], a.y[i], a.vx[i], a.vy[i]);
+
+    for (int t = 0; t < 500; t++) {
+        std::vector<int> killedA = a.update(forward, index, 520, 450);
+        std::vector<int> killedB = b.update(backward, index, 520, 450);
+        ASSERT_EQ(killedA, killedB);
+    }
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(a.x[i], b.x[n - 1 - i]);
+        EXPECT_EQ(a.vy[i], b.vy[n - 1 - i]);
+    }
+}
+
+// a paddle far below everything, for steps that should never touch it
+const Rect NO_PADDLE{ 0.f, 10000.f, 1.f, 1.f };
+float noBounce() { return 0.f; }
+
+// one ball in a BallSet follows the same path as updatePhysicsSwept
+TEST(ArkanoidBalls, SingleBallMatchesUpdatePhysicsSwept) {
+    std::vector<Block> alone = latticeBlocks(10, 10), batched = alone;
+    BlockIndex index(batched, 42.f, 20.f, 43.f, 20.f);
+    BallSet balls(3.f, 3.f, 6.f, 6.f);
+    balls.add(300.f, 300.f, 6.f, -5.f);
+    std::vector<int> killed;
+
+    float x = 300.f, y = 300.f, vx = 6.f, vy = -5.f;
+    for (int t = 0; t < 2000; t++) {
+        killed.clear();
+        updatePhysicsSwept(x, y, vx, vy, alone, index, 3.f, 3.f, 6.f, 6.f, 520, 450, &killed);
+        std::sort(killed.begin(), killed.end());
+        ASSERT_EQ(killed, balls.updateSwept(batched, index, 520, 450, NO_PADDLE, noBounce));
+        ASSERT_EQ(x, balls.x[0]);
+        ASSERT_EQ(y, balls.y[0]);
+        ASSERT_EQ(vx, balls.vx[0]);
+        ASSERT_EQ(vy, balls.vy[0]);
+    }
+}
+
+// two balls sweeping into the same block in the same tick both bounce off it
+TEST(ArkanoidBalls, SweptSameBlockSameTickBouncesBoth) {
+    std::vector<Block> blocks;
+    blocks.push_back(Block{ 100.f, 100.f, true });
+    BlockIndex index(blocks, 16.f, 8.f, 43.f, 20.f);
+    BallSet balls(0.f, 0.f, 6.f, 6.f);
+    balls.add(90.f, 100.f, 5.f, 0.f);   // from the left
+    balls.add(120.f, 101.f, -5.f, 0.f); // from the right
+
+    std::vector<int> killed = balls.updateSwept(blocks, index, 800, 600, NO_PADDLE, noBounce);
+
+    EXPECT_FALSE(blocks[0].alive);
+    EXPECT_EQ(std::vector<int>{ 0 }, killed);
+    EXPECT_EQ(-5.f, balls.vx[0]);
+    EXPECT_EQ(5.f, balls.vx[1]);
+}
+
+// only the ball that lands on the paddle is sent back up
+TEST(ArkanoidBalls, PaddleBouncesTheBallsOnIt) {
+    std::vector<Block> blocks;
+    BlockIndex index(blocks, 42.f, 20.f, 43.f, 20.f);
+    BallSet balls(3.f, 3.f, 6.f, 6.f);
+    balls.add(100.f, 420.f, 0.f, 5.f); // lands on the paddle
+    balls.add(300.f, 420.f, 0.f, 5.f); // misses it
+    Rect paddle{ 80.f, 428.f, 60.f, 10.f };
+
+    balls.updateSwept(blocks, index, 520, 450, paddle, [] { return -3.f; });
+
+    EXPECT_EQ(-3.f, balls.vy[0]);
+    EXPECT_EQ(5.f, balls.vy[1]);
+}
+
+TEST(ArkanoidBalls, SplitMirrorsEachBallUpToTheLimit) {
+    BallSet balls(3.f, 3.f, 6.f, 6.f);
+    balls.add(10.f, 20.f, 6.f, -5.f);
+
+    balls.split(64);
+    ASSERT_EQ(2, balls.size());
+    EXPECT_EQ(10.f, balls.x[1]);
+    EXPECT_EQ(-6.f, balls.vx[1]);
+    EXPECT_EQ(-5.f, balls.vy[1]);
+
+    balls.split(3);
+    EXPECT_EQ(3, balls.size());
+}
+
+// a ball moving straight up at `speed` under a row of 8 px tall blocks
+struct UpShot {
+    std::vector<Block> blocks;
+    float x, y, vx, vy;
+
+    UpShot(float speed, float startY) : x(100.f), y(startY), vx(0.f), vy(-speed) {
+        for (int i = 0; i < 10; i++)
+            blocks.push_back(Block{ 43.f * i, 100.f, true });
+    }
+};
+
+TEST(ArkanoidSwept, StepByStepPhysicsTunnelsAtSpeed) {
+    UpShot shot(50.f, 130.f);
+    BlockIndex index(shot.blocks, 42.f, 8.f, 43.f, 20.f);
+
+    updatePhysics(shot.x, shot.y, shot.vx, shot.vy, shot.blocks, index, 0.f, 0.f, 6.f, 6.f, 520, 450);
+
+    // jumped from below the row to above it without touching it
+    EXPECT_EQ(80.f, shot.y);
+    EXPECT_TRUE(shot.blocks[2].alive);
+}
+
+TEST(ArkanoidSwept, SweptBallStopsAtTheBlock) {
+    UpShot shot(50.f, 130.f);
+    BlockIndex index(shot.blocks, 42.f, 8.f, 43.f, 20.f);
+
+    updatePhysicsSwept(shot.x, shot.y, shot.vx, shot.vy, shot.blocks, index, 0.f, 0.f, 6.f, 6.f, 520, 450);
+
+    EXPECT_FALSE(shot.blocks[2].alive);
+    EXPECT_EQ(50.f, shot.vy);
+    // touched the underside at y = 108, then bounced back down for the other 28 px
+    EXPECT_FLOAT_EQ(136.f, shot.y);
+}
+
+// from every speed up to 50 px a tick and every starting offset, the ball
+// never gets past the row and exactly one block is destroyed
+TEST(ArkanoidSwept, NoTunnelingUpTo50PixelsPerTick) {
+    for (int speed = 1; speed <= 50; speed++)
+        for (int offset = 0; offset < speed; offset++) {
+            UpShot shot(float(speed), 200.f + offset);
+            BlockIndex index(shot.blocks, 42.f, 8.f, 43.f, 20.f);
+
+            for (int t = 0; t < 200 && shot.vy < 0; t++) {
+                updatePhysicsSwept(shot.x, shot.y, shot.vx, shot.vy, shot.blocks, index, 0.f, 0.f, 6.f, 6.f, 520, 450);
+                ASSERT_GE(shot.y, 108.f - 1e-3f) << "speed " << speed << " offset " << offset;
+            }
+
+            int alive = 0;
+            for (auto& b : shot.blocks) alive += b.alive;
+            ASSERT_EQ(9, alive) << "speed " << speed << " offset " << offset;
+            ASSERT_FALSE(shot.blocks[2].alive);
+            ASSERT_GT(shot.vy, 0.f);
+        }
+}
+
+TEST(ArkanoidSwept, DiagonalNoTunnelingThroughColumn) {
+    // a column of 8 px wide blocks and balls crossing it at up to 50 px a tick
+    std::vector<Block> column;
+    for (int j = 0; j < 20; j++)
+        column.push_back(Block{ 200.f, 20.f * j, true });
+
+    for (int speed = 10; speed <= 50; speed += 5) {
+        std::vector<Block> blocks = column;
+        BlockIndex index(blocks, 8.f, 20.f, 43.f, 20.f);
+        float x = 100.f, y = 150.f, vx = float(speed), vy = speed * 0.3f;
+
+        for (int t = 0; t < 100 && vx > 0; t++) {
+            updatePhysicsSwept(x, y, vx, vy, blocks, index, 0.f, 0.f, 6.f, 6.f, 520, 450);
+            ASSERT_LE(x + 6.f, 200.f + 1e-3f) << "speed " << speed;
+        }
+        EXPECT_LT(vx, 0.f);
+    }
+}
+
+// overlapping two blocks at the end of the step used to flip the velocity
+// twice, so the ball kept going; now the first contact wins
+TEST(ArkanoidSwept, TwoBlocksAtOnceBounceOnce) {
+    std::vector<Block> blocks;
+    blocks.push_back(Block{ 58.f, 100.f, true });
+    blocks.push_back(Block{ 100.f, 100.f, true });
+    BlockIndex index(blocks, 42.f, 8.f, 43.f, 20.f);
+    std::vector<Block> stepped = blocks;
+
+    // the ball straddles the seam between the two blocks
+    float x = 97.f, y = 120.f, vx = 0.f, vy = -15.f;
+    float sx = x, sy = y, svx = vx, svy = vy;
+
+    updatePhysics(sx, sy, svx, svy, stepped, index, 0.f, 0.f, 6.f, 6.f, 520, 450);
+    EXPECT_EQ(-15.f, svy);
+
+    updatePhysicsSwept(x, y, vx, vy, blocks, index, 0.f, 0.f, 6.f, 6.f, 520, 450);
+    EXPECT_EQ(15.f, vy);
+    EXPECT_FALSE(blocks[0].alive);
+    EXPECT_TRUE(blocks[1].alive);
+}
+
+// of two blocks on the path the nearer one is hit and the ball turns back before the other
+TEST(ArkanoidSwept, EarliestHitWins) {
+    std::vector<Block> blocks;
+    blocks.push_back(Block{ 100.f, 60.f, true }); // reached second
+    blocks.push_back(Block{ 100.f, 80.f, true }); // reached first
+    BlockIndex index(blocks, 42.f, 8.f, 43.f, 20.f);
+
+    float x = 110.f, y = 100.f, vx = 0.f, vy = -45.f;
+    updatePhysicsSwept(x, y, vx, vy, blocks, index, 0.f, 0.f, 6.f, 6.f, 520, 450);
+
+    EXPECT_TRUE(blocks[0].alive);
+    EXPECT_FALSE(blocks[1].alive);
+    EXPECT_GT(vy, 0.f);
+}
+
+// the swept step reports the blocks it destroys, as the indexed one does,
+// so the game can keep its packed list of live blocks up to date
+TEST(ArkanoidSwept, ReportsDestroyedBlocks) {
+    std::vector<Block> blocks = latticeBlocks(10, 10);
+    BlockIndex index(blocks, 42.f, 20.f, 43.f, 20.f);
+    AliveBlocks alive(blocks);
+    std::vector<int> killed;
+
+    float x = 300.f, y = 300.f, vx = 6.f, vy = -5.f;
+    for (int t = 0; t < 3000; t++) {
+        updatePhysicsSwept(x, y, vx, vy, blocks, index, 3.f, 3.f, 6.f, 6.f, 520, 450, &killed);
+        for (int b : killed) {
+            ASSERT_FALSE(blocks[b].alive);
+            ASSERT_GE(alive.remove(b), 0);
+        }
+        killed.clear();
+    }
+
+    int live = 0;
+    for (auto& b : blocks) live += b.alive;
+    EXPECT_EQ(live, alive.size());
+    EXPECT_LT(live, 100);
+}
+
+TEST(ArkanoidLevel, ReadsBlocksFromText) {
+    std::istringstream text(
+        "# a small level\n"
+        "\n"
+        "spacing 43 20\n"
+        "origin 10 5\n"
+        "#.#\n"
+        "\n"
+        "..#\r\n");
+    Level level;
+
+    ASSERT_TRUE(readLevel(text, level));
+
+    EXPECT_EQ(43.f, level.spacingX);
+    EXPECT_EQ(20.f, level.spacingY);
+    ASSERT_EQ(3u, level.blocks.size());
+    EXPECT_EQ(10.f, level.blocks[0].x);
+    EXPECT_EQ(5.f, level.blocks[0].y);
+    EXPECT_EQ(96.f, level.blocks[1].x);
+    EXPECT_EQ(96.f, level.blocks[2].x);
+    EXPECT_EQ(45.f, level.blocks[2].y); // the blank line is an empty row
+    EXPECT_TRUE(level.blocks[2].alive);
+}
+
+// a comment between the rows is skipped, not read as a row of blocks
+TEST(ArkanoidLevel, CommentsAreAllowedBetweenRows) {
+    std::istringstream text(
+        "spacing 43 20\n"
+        "origin 0 0\n"
+        "#.\n"
+        "# the second row\n"
+        ".#\n"
+        "#\n");
+    Level level;
+
+    ASSERT_TRUE(readLevel(text, level));
+
+    ASSERT_EQ(3u, level.blocks.size());
+    EXPECT_EQ(0.f, level.blocks[0].y);
+    EXPECT_EQ(43.f, level.blocks[1].x);
+    EXPECT_EQ(20.f, level.blocks[1].y);
+    EXPECT_EQ(40.f, level.blocks[2].y); // a lone '#' is a row, not a comment
+}
+
+TEST(ArkanoidLevel, RejectsTextThatIsNotALevel) {
+    Level level = latticeLevel(2, 2, 43.f, 20.f, 0.f, 0.f);
+
+    std::istringstream noHeader("##########\n");
+    std::istringstream badSpacing("spacing 0 20\norigin 0 0\n#\n");
+    std::istringstream unknownKey("spacing 43 20\ncolour 1 2\n");
+
+    EXPECT_FALSE(readLevel(noHeader, level));
+    EXPECT_FALSE(readLevel(badSpacing, level));
+    EXPECT_FALSE(readLevel(unknownKey, level));
+    EXPECT_EQ(4u, level.blocks.size());
+    EXPECT_FALSE(loadLevel("no/such/level.txt", level));
+}
+
+// a generated level of 100k blocks survives writing and reading back
+TEST(ArkanoidLevel, LargeLevelRoundTrips) {
+    Level level = latticeLevel(400, 250, 43.f, 20.f, 43.f, 20.f);
+    level.blocks[7].alive = false;
+
+    std::stringstream file;
+    writeLevel(file, level);
+    Level read;
+    ASSERT_TRUE(readLevel(file, read));
+
+    ASSERT_EQ(level.blocks.size() - 1, read.blocks.size());
+    EXPECT_EQ(43.f, read.originX);
+    EXPECT_EQ(20.f, read.originY);
+
+    BlockIndex index(read.blocks, 42.f, 20.f, read.spacingX, read.spacingY);
+    int found = 0;
+    index.forEachNear(Rect{ 43.f * 200, 20.f * 100, 1.f, 1.f }, [&](int i) {
+        if (read.blocks[i].x == 43.f * 200 && read.blocks[i].y == 20.f * 100) found++;
+    });
+    EXPECT_EQ(1, found);
+}
+
+TEST(ArkanoidAliveBlocks, RemovingMovesTheLastIntoTheGap) {
+    std::vector<Block> blocks = latticeBlocks(2, 2);
+    blocks[1].alive = false;
+    AliveBlocks alive(blocks);
+
+    ASSERT_EQ(3, alive.size());
+    EXPECT_EQ(0, alive[0]);
+    EXPECT_EQ(2, alive[1]);
+    EXPECT_EQ(3, alive[2]);
+
+    EXPECT_EQ(0, alive.remove(0));
+    EXPECT_EQ(2, alive.size());
+    EXPECT_EQ(3, alive[0]);
+    EXPECT_EQ(2, alive[1]);
+
+    EXPECT_EQ(-1, alive.remove(0)); // already gone
+    EXPECT_EQ(-1, alive.remove(1)); // never alive
+    EXPECT_EQ(1, alive.remove(2));  // the last one, nothing moves
+    EXPECT_EQ(1, alive.size());
+    EXPECT_EQ(3, alive[0]);
+}
+
+// following the destroyed blocks reported by updatePhysics keeps the
+// packed list equal to the blocks still alive
+TEST(ArkanoidAliveBlocks, TracksBlocksDestroyedByTheBall) {
+    std::vector<Block> blocks = latticeBlocks(10, 10);
+    BlockIndex index(blocks, 42.f, 20.f, 43.f, 20.f);
+    AliveBlocks alive(blocks);
+    std::vector<int> killed;
+
+    float x = 300.f, y = 300.f, vx = 6.f, vy = -5.f;
+    for (int t = 0; t < 3000; t++) {
+        updatePhysics(x, y, vx, vy, blocks, index, 3.f, 3.f, 6.f, 6.f, 520, 450, &killed);
+        for (int b : killed) ASSERT_GE(alive.remove(b), 0);
+        killed.clear();
+    }
+
+    std::vector<int> expected, packed;
+    for (int i = 0; i < (int)blocks.size(); i++)
+        if (blocks[i].alive) expected.push_back(i);
+    for (int s = 0; s < alive.size(); s++) packed.push_back(alive[s]);
+    std::sort(packed.begin(), packed.end());
+    EXPECT_EQ(expected, packed);
+    EXPECT_LT(alive.size(), 100);
+}
@@ -1,221 +1,97 @@
 #include <SFML/Graphics.hpp>
 #include <time.h>
-#include <list>
+#include "AsteroidsWorld.h"
 using namespace sf;
+using namespace Asteroids;
 
-const int W = 1200;
-const int H = 800;
 
-float DEGTORAD = 0.017453f;
-
-class Animation
+void draw(RenderWindow &app, Sprite &sprite, Texture sheets[], const Entity &e)
 {
-   public:
-   float Frame, speed;
-   Sprite sprite;
-   std::vector<IntRect> frames;
-
-   Animation(){}
-
-   Animation (Texture &t, int x, int y, int w, int h, int count, float Speed)
-   {
-     Frame = 0;
-     speed = Speed;
-
-     for (int i=0;i<count;i++)
-      frames.push_back( IntRect(x+i*w, y, w, h)  );
-
-     sprite.setTexture(t);
-     sprite.setOrigin(w/2,h/2);
-     sprite.setTextureRect(frames[0]);
-   }
-
-
-   void update()
-   {
-     Frame += speed;
-     int n = frames.size();
-     if (Frame >= n) Frame -= n;
-     if (n>0) sprite.setTextureRect( frames[int(Frame)] );
-   }
-
-   bool isEnd()
-   {
-     return Frame+speed>=frames.size();
-   }
-
-};
+   const FrameRect &f = e.anim.current();
+   sprite.setTexture(sheets[e.anim.sheet()]);
+   sprite.setTextureRect(IntRect(f.left, f.top, f.width, f.height));
+   sprite.setOrigin(f.width/2,f.height/2);
+   sprite.setPosition(e.x,e.y);
+   sprite.setRotation(e.angle+90);
+   app.draw(sprite);
+}
 
 
-class Entity
+// one quad list per texture sheet, rebuilt every frame and drawn with a
+// single call per sheet no matter how many entities use it
+class SpriteBatch
 {
-   public:
-   float x,y,dx,dy,R,angle;
-   bool life;
-   std::string name;
-   Animation anim;
-
-   Entity()
-   {
-     life=1;
-   }
+   VertexArray quads[SHEET_COUNT];
 
-   void settings(Animation &a,int X,int Y,float Angle=0,int radius=1)
-   {
-     anim = a;
-     x=X; y=Y;
-     angle = Angle;
-     R = radius;
-   }
-
-   virtual void update(){};
-
-   void draw(RenderWindow &app)
-   {
-     anim.sprite.setPosition(x,y);
-     anim.sprite.setRotation(angle+90);
-     app.draw(anim.sprite);
-
-     CircleShape circle(R);
-     circle.setFillColor(Color(255,0,0,170));
-     circle.setPosition(x,y);
-     circle.setOrigin(R,R);
-     //app.draw(circle);
-   }
-
-   virtual ~Entity(){};
-};
-
-
-class asteroid: public Entity
-{
    public:
-   asteroid()
+   SpriteBatch()
    {
-     dx=rand()%8-4;
-     dy=rand()%8-4;
-     name="asteroid";
+     for (auto &q : quads) q.setPrimitiveType(Quads);
    }
 
-   void update()
+   void clear()
    {
-     x+=dx;
-     y+=dy;
-
-     if (x>W) x=0;  if (x<0) x=W;
-     if (y>H) y=0;  if (y<0) y=H;
+     for (auto &q : quads) q.clear();
    }
 
-};
-
-
-class bullet: public Entity
-{
-   public:
-   bullet()
+   void add(const Entity &e)
    {
-     name="bullet";
+     const FrameRect &f = e.anim.current();
+     float a = (e.angle+90)*DEGTORAD;
+     float c = cos(a), s = sin(a);
+     float hw = f.width/2, hh = f.height/2;
+
+     const float corner[4][2] = { {-hw,-hh}, {hw,-hh}, {hw,hh}, {-hw,hh} };
+     VertexArray &q = quads[e.anim.sheet()];
+     for (int i=0;i<4;i++)
+      {
+        float lx = corner[i][0], ly = corner[i][1];
+        q.append(Vertex(Vector2f(e.x + lx*c - ly*s, e.y + lx*s + ly*c),
+                        Vector2f(f.left + hw + lx, f.top + hh + ly)));
+      }
    }
 
-   void  update()
+   void draw(RenderWindow &app, Texture sheets[])
    {
-     dx=cos(angle*DEGTORAD)*6;
-     dy=sin(angle*DEGTORAD)*6;
-     // angle+=rand()%7-3;  /*try this*/
-     x+=dx;
-     y+=dy;
-
-     if (x>W || x<0 || y>H || y<0) life=0;
+     const Sheet order[SHEET_COUNT] = { ROCK, ROCK_SMALL, SPACESHIP, FIRE_BLUE, EXPLOSION_C, EXPLOSION_B };
+     for (Sheet s : order)
+      if (quads[s].getVertexCount() > 0)
+        app.draw(quads[s], RenderStates(&sheets[s]));
    }
-
 };
 
 
-class player: public Entity
-{
-   public:
-   bool thrust;
-
-   player()
-   {
-     name="player";
-   }
-
-   void update()
-   {
-     if (thrust)
-      { dx+=cos(angle*DEGTORAD)*0.2;
-        dy+=sin(angle*DEGTORAD)*0.2; }
-     else
-      { dx*=0.99;
-        dy*=0.99; }
-
-    int maxSpeed=15;
-    float speed = sqrt(dx*dx+dy*dy);
-    if (speed>maxSpeed)
-     { dx *= maxSpeed/speed;
-       dy *= maxSpeed/speed; }
-
-    x+=dx;
-    y+=dy;
-
-    if (x>W) x=0; if (x<0) x=W;
-    if (y>H) y=0; if (y<0) y=H;
-   }
-
-};
-
-
-bool isCollide(Entity *a,Entity *b)
-{
-  return (b->x - a->x)*(b->x - a->x)+
-         (b->y - a->y)*(b->y - a->y)<
-         (a->R + b->R)*(a->R + b->R);
-}
-
-
 int asteroids()
 {
-    srand(time(0));
 
     RenderWindow app(VideoMode(W, H), "Asteroids!");
     app.setFramerateLimit(60);
 
-    Texture t1,t2,t3,t4,t5,t6,t7;
-    t1.loadFromFile("images/asteroids/spaceship.png");
+    Texture sheets[SHEET_COUNT], t2;
+    sheets[SPACESHIP].loadFromFile("images/asteroids/spaceship.png");
     t2.loadFromFile("images/asteroids/background.jpg");
-    t3.loadFromFile("images/asteroids/explosions/type_C.png");
-    t4.loadFromFile("images/asteroids/rock.png");
-    t5.loadFromFile("images/asteroids/fire_blue.png");
-    t6.loadFromFile("images/asteroids/rock_small.png");
-    t7.loadFromFile("images/asteroids/explosions/type_B.png");
+    sheets[EXPLOSION_C].loadFromFile("images/asteroids/explosions/type_C.png");
+    sheets[ROCK].loadFromFile("images/asteroids/rock.png");
+    sheets[FIRE_BLUE].loadFromFile("images/asteroids/fire_blue.png");
+    sheets[ROCK_SMALL].loadFromFile("images/asteroids/rock_small.png");
+    sheets[EXPLOSION_B].loadFromFile("images/asteroids/explosions/type_B.png");
 
-    t1.setSmooth(true);
+    sheets[SPACESHIP].setSmooth(true);
     t2.setSmooth(true);
 
     Sprite background(t2);
+    Sprite sprite;
+    SpriteBatch batch;
+    bool batched = true; // B switches to one draw call per sprite for comparison
 
-    Animation sExplosion(t3, 0,0,256,256, 48, 0.5);
-    Animation sRock(t4, 0,0,64,64, 16, 0.2);
-    Animation sRock_small(t6, 0,0,64,64, 16, 0.2);
-    Animation sBullet(t5, 0,0,32,64, 16, 0.8);
-    Animation sPlayer(t1, 40,0,40,40, 1, 0);
-    Animation sPlayer_go(t1, 40,40,40,40, 1, 0);
-    Animation sExplosion_ship(t7, 0,0,192,192, 64, 0.5);
+    World world(defaultAnimations(), (uint32_t)time(0));
+    world.spawnRocks(15);
 
+    player *p = world.p;
 
-    std::list<Entity*> entities;
-
-    for(int i=0;i<15;i++)
-    {
-      asteroid *a = new asteroid();
-      a->settings(sRock, rand()%W, rand()%H, rand()%360, 25);
-      entities.push_back(a);
-    }
-
-    player *p = new player();
-    p->settings(sPlayer,200,200,0,20);
-    entities.push_back(p);
+    Input input = {};
+    Clock clock;
+    float lag = 0;
 
     /////main loop/////
     while (app.isOpen())
@@ -227,90 +103,46 @@ int asteroids()
                 app.close();
 
             if (event.type == Event::KeyPressed)
-             if (event.key.code == Keyboard::Space)
-              {
-                bullet *b = new bullet();
-                b->settings(sBullet,p->x,p->y,p->angle,10);
-                entities.push_back(b);
-              }
-        }
-
-    if (Keyboard::isKeyPressed(Keyboard::Right)) p->angle+=3;
-    if (Keyboard::isKeyPressed(Keyboard::Left))  p->angle-=3;
-    if (Keyboard::isKeyPressed(Keyboard::Up)) p->thrust=true;
-    else p->thrust=false;
-
-
-    for(auto a:entities)
-     for(auto b:entities)
-     {
-      if (a->name=="asteroid" && b->name=="bullet")
-       if ( isCollide(a,b) )
-           {
-            a->life=false;
-            b->life=false;
-
-            Entity *e = new Entity();
-            e->settings(sExplosion,a->x,a->y);
-            e->name="explosion";
-            entities.push_back(e);
-
-
-            for(int i=0;i<2;i++)
             {
-             if (a->R==15) continue;
-             Entity *e = new asteroid();
-             e->settings(sRock_small,a->x,a->y,rand()%360,15);
-             entities.push_back(e);
+                if (event.key.code == Keyboard::Space)
+                    input.fire = true; // held until the next tick consumes it
+                else if (event.key.code == Keyboard::B)
+                    batched = !batched;
             }
+        }
 
-           }
-
-      if (a->name=="player" && b->name=="asteroid")
-       if ( isCollide(a,b) )
-           {
-            b->life=false;
-
-            Entity *e = new Entity();
-            e->settings(sExplosion_ship,a->x,a->y);
-            e->name="explosion";
-            entities.push_back(e);
-
-            p->settings(sPlayer,W/2,H/2,0,20);
-            p->dx=0; p->dy=0;
-           }
-     }
-
-
-    if (p->thrust)  p->anim = sPlayer_go;
-    else   p->anim = sPlayer;
-
-
-    for(auto e:entities)
-     if (e->name=="explosion")
-      if (e->anim.isEnd()) e->life=0;
-
-    if (rand()%150==0)
-     {
-       asteroid *a = new asteroid();
-       a->settings(sRock, 0,rand()%H, rand()%360, 25);
-       entities.push_back(a);
-     }
+    input.right  = Keyboard::isKeyPressed(Keyboard::Right);
+    input.left   = Keyboard::isKeyPressed(Keyboard::Left);
+    input.thrust = Keyboard::isKeyPressed(Keyboard::Up);
 
-    for(auto i=entities.begin();i!=entities.end();)
+    // run as many fixed ticks as real time allows; cap the backlog after a stall
+    lag += clock.restart().asSeconds();
+    if (lag > 0.25f) lag = 0.25f;
+    while (lag >= TICK_SECONDS)
     {
-      Entity *e = *i;
-
-      e->update();
-      e->anim.update();
-
-      if (e->life==false) {i=entities.erase(i); delete e;}
-      else i++;
+      world.step(input);
+      input.fire = false;
+      lag -= TICK_SECONDS;
     }
 
    //////draw//////
    app.draw(background);
-   for(auto i:entities) i->draw(app);
+   if (batched)
+    {
+      batch.clear();
+      for(auto &e:world.asteroids) batch.add(e);
+      batch.add(*p);
+      for(auto &e:world.bullets) batch.add(e);
+      for(auto &e:world.explosions) batch.add(e);
+      batch.draw(app, sheets);
+    }
+   else
+    {
+      for(auto &e:world.asteroids) draw(app, sprite, sheets, e);
+      draw(app, sprite, sheets, *p);
+      for(auto &e:world.bullets) draw(app, sprite, sheets, e);
+      for(auto &e:world.explosions) draw(app, sprite, sheets, e);
+    }
    app.display();
     }
 
@@ -0,0 +1,519 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <thread>
+#include <vector>
+#include "ArkanoidBalls.h"
+#include "ArkanoidCollision.h"
+#include "AsteroidsCollision.h"
+#include "AsteroidsKinematics.h"
+#include "AsteroidsWorld.h"
+#include "BitGrid.h"
+#include "Grid.h"
+#include "TetrisAI.h"
+#include "TetrisGame.h"
+#include "TetrisReplay.h"
+#include "XonixEnemy.h"
+#include "XonixGame.h"
+
+using namespace std;
+
+// runs body() `repeats` times and returns the mean wall time in milliseconds
+template<class Body>
+double timeMs(int repeats, Body body)
+{
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repeats; i++) body();
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / repeats;
+}
+
+// per-frame cost of the asteroids collision pass: every pair vs. spatial hash
+void asteroidsCollisionBenchmark()
+{
+    const float W = 1200, H = 800;
+    struct Body { float x, y, R; };
+
+    cout << "asteroids collision (ms/frame)\n";
+    cout << "entities    brute force    spatial hash    hits\n";
+
+    for (int n : {100, 1000, 10000})
+    {
+        vector<Body> bodies(n);
+        for (auto &b : bodies)
+            b = Body{ float(rand() % int(W)), float(rand() % int(H)), rand() % 2 ? 25.f : 10.f };
+
+        int repeats = n >= 10000 ? 3 : 50;
+        int bruteHits = 0, hashHits = 0;
+
+        double brute = timeMs(repeats, [&] {
+            bruteHits = 0;
+            for (auto &a : bodies)
+                for (auto &b : bodies)
+                    if (&a != &b && Asteroids::circlesOverlap(a.x, a.y, a.R, b.x, b.y, b.R)) bruteHits++;
+        });
+
+        Asteroids::SpatialHash grid(W, H, 50);
+        double hashed = timeMs(repeats, [&] {
+            hashHits = 0;
+            grid.clear();
+            for (int i = 0; i < n; i++) grid.insert(i, bodies[i].x, bodies[i].y);
+            for (int i = 0; i < n; i++)
+                grid.query(bodies[i].x, bodies[i].y, [&](int j) {
+                    const Body &a = bodies[i], &b = bodies[j];
+                    if (i != j && Asteroids::circlesOverlap(a.x, a.y, a.R, b.x, b.y, b.R)) hashHits++;
+                });
+        });
+
+        cout << n << "\t    " << brute << "\t   " << hashed << "\t    " << hashHits
+             << (hashHits == bruteHits ? "" : "  MISMATCH") << "\n";
+    }
+}
+
+// rapid fire: `perTick` bullets spawned from the centre every tick and flying
+// off screen, through the old heap-allocated list and through the pool
+void asteroidsSpawnBenchmark()
+{
+    using namespace Asteroids;
+    const int ticks = 2000;
+    Animations anims = defaultAnimations();
+
+    cout << "asteroids bullet spawn/despawn (M bullets/s)\n";
+    cout << "per tick    list<Entity*>    Pool\n";
+
+    for (int perTick : {10, 100})
+    {
+        double listMs = timeMs(1, [&] {
+            std::list<bullet*> bullets;
+            for (int t = 0; t < ticks; t++)
+            {
+                for (int i = 0; i < perTick; i++)
+                {
+                    bullet *b = new bullet();
+                    b->settings(anims.bullet, W / 2, H / 2, i * 37, 10);
+                    bullets.push_back(b);
+                }
+                for (auto i = bullets.begin(); i != bullets.end();)
+                {
+                    bullet *b = *i;
+                    b->update();
+                    if (b->life == false) { i = bullets.erase(i); delete b; }
+                    else i++;
+                }
+            }
+            for (auto b : bullets) delete b;
+        });
+
+        double poolMs = timeMs(1, [&] {
+            Pool<bullet> bullets(perTick * 200);
+            for (int t = 0; t < ticks; t++)
+            {
+                for (int i = 0; i < perTick; i++)
+                {
+                    bullet b;
+                    b.settings(anims.bullet, W / 2, H / 2, i * 37, 10);
+                    bullets.add(b);
+                }
+                for (auto &b : bullets) b.update();
+                bullets.removeIf([](const bullet &b) { return b.life == false; });
+            }
+        });
+
+        double spawned = double(ticks) * perTick;
+        cout << perTick << "\t    " << spawned / listMs / 1000 << "\t     " << spawned / poolMs / 1000 << "\n";
+    }
+}
+
+// rock and bullet movement only: per-entity update recomputing the bullet's
+// cos/sin every tick (the old bullet::update) vs. the packed scalar and SIMD kernels
+void asteroidsKinematicsBenchmark()
+{
+    using namespace Asteroids;
+    const int n = 100000, repeats = 200;
+
+    vector<bullet> bullets(n);
+    Motion m;
+    m.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        bullets[i].x = m.x[i] = rand() % W;
+        bullets[i].y = m.y[i] = rand() % H;
+        bullets[i].angle = rand() % 360;
+        m.dx[i] = rand() % 8 - 4;
+        m.dy[i] = rand() % 8 - 4;
+    }
+
+    double perEntity = timeMs(repeats, [&] {
+        for (auto &b : bullets)
+        {
+            b.dx = cos(b.angle * DEGTORAD) * 6;
+            b.dy = sin(b.angle * DEGTORAD) * 6;
+            b.x += b.dx; b.y += b.dy;
+            if (b.x > W) b.x = 0;
+            if (b.x < 0) b.x = W;
+            if (b.y > H) b.y = 0;
+            if (b.y < 0) b.y = H;
+        }
+    });
+    double scalar = timeMs(repeats, [&] {
+        moveAndWrapScalar(m.x.data(), m.y.data(), m.dx.data(), m.dy.data(), 0, n, W, H);
+    });
+    double simd = timeMs(repeats, [&] {
+        moveAndWrap(m.x.data(), m.y.data(), m.dx.data(), m.dy.data(), n, W, H);
+    });
+
+    cout << "asteroids kinematics, " << n << " entities (ms/tick)\n";
+    cout << "per-entity trig " << perEntity << "    packed scalar " << scalar << "    packed SIMD " << simd
+#ifndef ASTEROIDS_SSE2
+         << " (no SSE2, scalar fallback)"
+#endif
+         << "\n";
+}
+
+// column headings for the rows asteroidsStressBenchmark() prints
+void asteroidsStressHeader()
+{
+    cout << "asteroids headless stress\n";
+    cout << "rocks\tfire/t\tticks\tticks/s\t\tp50 us\tp99 us\tpeak entities\n";
+}
+
+// whole asteroids ticks (spawn, update, collision, splitting, cleanup) without a window,
+// starting from `rocks` big rocks while the ship spins and fires `firePerTick`
+void asteroidsStressBenchmark(int rocks, float firePerTick, int ticks)
+{
+    using namespace Asteroids;
+
+    World world(defaultAnimations(), 12345, 1 << 16);
+    world.spawnRocks(rocks);
+
+    vector<double> tickUs(ticks);
+    int peak = 0;
+    float owed = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < ticks; t++)
+    {
+        Input in = {};
+        in.right = true;
+        owed += firePerTick;
+        in.fire = owed >= 1;
+        if (in.fire) owed -= 1;
+
+        auto tickStart = chrono::steady_clock::now();
+        while (owed >= 1) { world.fire(); owed -= 1; }
+        world.step(in);
+        chrono::duration<double, micro> took = chrono::steady_clock::now() - tickStart;
+        tickUs[t] = took.count();
+
+        peak = max(peak, world.asteroids.size() + world.bullets.size() + world.explosions.size() + 1);
+    }
+    chrono::duration<double> total = chrono::steady_clock::now() - start;
+
+    sort(tickUs.begin(), tickUs.end());
+    cout << rocks << "\t" << firePerTick << "\t" << ticks << "\t"
+         << int(ticks / total.count()) << "\t\t" << tickUs[ticks / 2] << "\t" << tickUs[ticks * 99 / 100]
+         << "\t" << peak << "\n";
+}
+
+// xonix capture on square boards: a vertical new wall cuts off a third of
+// the board, then the side without the four enemies is filled and scored
+template<class Board>
+double xonixCaptureMs(int size)
+{
+    vector<Seed> enemies = { {size / 2, size / 2}, {size / 4, size - 3}, {size - 3, size / 2}, {2, 2 * size / 3} };
+
+    int repeats = size >= 4096 ? 3 : 20;
+    double total = 0;
+    for (int r = 0; r < repeats; r++)
+    {
+        Board grid(size, size, 1);
+        for (int y = 1; y < size - 1; y++)
+            grid.newWall(y, size / 3);
+
+        float captured = 0;
+        total += timeMs(1, [&] {
+            grid.markConnectedCellsNotToBeFilled(enemies);
+            grid.fillEmptyCells();
+            captured = grid.capturedPercent();
+        });
+        if (captured < 30 || captured > 40) cout << "unexpected capture " << captured << "%\n";
+    }
+    return total / repeats;
+}
+
+void xonixFillBenchmark()
+{
+    cout << "xonix capture (ms per capture: mark, fill, score)\n";
+    cout << "board\t\tGrid\t\tBitGrid\n";
+
+    for (int size : {64, 256, 1024, 4096})
+        cout << size << "x" << size << "\t" << xonixCaptureMs<Grid>(size) << "\t" << xonixCaptureMs<BitGrid>(size) << "\n";
+}
+
+// enemies bouncing around the classic board with a third of it cut off by
+// a new wall they keep running over; speed is the largest step in pixels
+void xonixEnemyBenchmark(int count, int maxSpeed)
+{
+    const int ts = 18, rows = 25, cols = 40;
+    Grid grid(rows, cols, ts);
+    for (int y = 1; y < rows - 1; y++)
+        grid.newWall(y, cols / 3);
+
+    srand(9);
+    vector<Enemy> enemies;
+    for (int i = 0; i < count; i++)
+        enemies.push_back(Enemy(ts + rand() % ((cols - 2) * ts), ts + rand() % ((rows - 2) * ts), maxSpeed));
+
+    const int ticks = 2000;
+    int hits = 0;
+    double ms = timeMs(1, [&] {
+        for (int t = 0; t < ticks; t++)
+            for (auto &e : enemies)
+            {
+                e.move(grid);
+                hits += e.touchesNewWall(grid);
+            }
+    });
+
+    cout << count << "\t" << maxSpeed << "\t" << 1000.0 * count * ticks / ms / 1e6 << "\t\t" << hits << "\n";
+}
+
+// independent headless games split over `threads` threads, each driven by
+// a bot that turns every 40 ticks and restarts on game over
+void xonixParallelBenchmark(int games, int threads)
+{
+    const int ticks = 20000;
+    double ms = timeMs(1, [&] {
+        vector<thread> workers;
+        for (int w = 0; w < threads; w++)
+            workers.push_back(thread([=] {
+                for (int g = w; g < games; g += threads)
+                {
+                    XonixGame game(4, 1 + g);
+                    for (int t = 0; t < ticks; t++)
+                    {
+                        if (game.gameOver) game.reset();
+                        int turn = (t / 40) % 4;
+                        XonixInput input = { turn == 3, turn == 1, turn == 0, turn == 2 };
+                        game.tick(input);
+                    }
+                }
+            }));
+        for (auto &w : workers) w.join();
+    });
+
+    cout << games << "\t" << threads << "\t" << 1000.0 * games * ticks / ms / 1e6 << "\n";
+}
+
+// arkanoid block collision on square lattice levels: every block vs. the
+// block index, for balls dropped at random over the level
+void arkanoidBlockBenchmark()
+{
+    cout << "arkanoid block checks (us per ball rect)\n";
+    cout << "blocks\tscan\t\tindex\n";
+
+    for (int side : {10, 100, 316})
+    {
+        vector<Arkanoid::Block> blocks;
+        for (int i = 1; i <= side; i++)
+            for (int j = 1; j <= side; j++)
+                blocks.push_back(Arkanoid::Block{ i * 43.f, j * 20.f, true });
+        Arkanoid::BlockIndex index(blocks, 42.f, 20.f, 43.f, 20.f);
+
+        srand(2);
+        const int balls = 2000;
+        vector<Arkanoid::Rect> rects;
+        for (int i = 0; i < balls; i++)
+            rects.push_back(Arkanoid::Rect{ float(rand() % (side * 43)), float(rand() % (side * 20)), 6.f, 6.f });
+
+        // both see the same balls and kill the same blocks
+        float vel = 1;
+        vector<Arkanoid::Block> scanned = blocks, indexed = blocks;
+        double scanMs = timeMs(1, [&] {
+            for (auto &r : rects) Arkanoid::checkBlockCollisions(scanned, r, 42.f, 20.f, vel);
+        });
+        double indexMs = timeMs(1, [&] {
+            for (auto &r : rects) Arkanoid::checkBlockCollisions(indexed, index, r, vel);
+        });
+        cout << blocks.size() << "\t" << 1000 * scanMs / balls << "\t\t" << 1000 * indexMs / balls << "\n";
+    }
+}
+
+// many balls stepped together through a 100 x 100 block level, by the
+// step-by-step update and by the swept one with a paddle that the game
+// runs; blocks come back once the level is cleared so every tick has work
+// to do
+void arkanoidMultiBallBenchmark(int count)
+{
+    vector<Arkanoid::Block> level;
+    for (int i = 1; i <= 100; i++)
+        for (int j = 1; j <= 100; j++)
+            level.push_back(Arkanoid::Block{ i * 43.f, j * 20.f, true });
+    const int W = 101 * 43, H = 101 * 20;
+
+    // a paddle along the bottom, grown by the ball sprite's margin as arkanoid.cpp grows it
+    const Arkanoid::Rect paddle{ W / 2.f - 3, H - 23.f, 96.f, 20.f };
+    auto bounceSpeed = [] { return -float(rand() % 5 + 2); };
+
+    srand(6);
+    Arkanoid::BallSet start(3.f, 3.f, 6.f, 6.f);
+    for (int i = 0; i < count; i++)
+        start.add(float(rand() % W), float(rand() % H), float(rand() % 13 - 6), float(rand() % 11 - 5));
+
+    const int ticks = 2000;
+    size_t destroyed = 0;
+    auto run = [&](bool swept) {
+        vector<Arkanoid::Block> blocks = level;
+        Arkanoid::BlockIndex index(blocks, 42.f, 20.f, 43.f, 20.f);
+        Arkanoid::BallSet balls = start;
+        size_t alive = blocks.size();
+        destroyed = 0;
+        return timeMs(1, [&] {
+            for (int t = 0; t < ticks; t++)
+            {
+                size_t killed = swept ? balls.updateSwept(blocks, index, W, H, paddle, bounceSpeed).size()
+                                      : balls.update(blocks, index, W, H).size();
+                destroyed += killed;
+                alive -= killed;
+                if (alive == 0)
+                {
+                    for (auto &b : blocks) b.alive = true;
+                    alive = blocks.size();
+                }
+            }
+        });
+    };
+
+    double stepMs = run(false);
+    double sweptMs = run(true);
+    cout << count << "\t" << 1000.0 * count * ticks / stepMs / 1e6 << "\t\t"
+         << 1000.0 * count * ticks / sweptMs / 1e6 << "\t\t" << destroyed << "\n";
+}
+
+// the tetris bot playing on its own: pieces placed per second, one piece
+// at a time or looking one piece ahead, with the placements scored on a pool
+void tetrisBotBenchmark(bool lookahead, int threads)
+{
+    Tetris::ThreadPool pool(threads - 1);
+    Tetris::Bot bot(threads > 1 ? &pool : nullptr);
+    srand(22);
+    int pieces = 0, lines = 0, games = 1;
+    const int target = lookahead ? 2000 : 20000;
+    Tetris::Field field;
+    int next = rand() % Tetris::PIECE_COUNT;
+
+    double ms = timeMs(1, [&] {
+        while (pieces < target)
+        {
+            int piece = next;
+            next = rand() % Tetris::PIECE_COUNT;
+            Tetris::Placement move;
+            if (!bot.choose(field, piece, lookahead ? next : -1, move))
+            {
+                field.clear();
+                games++;
+                continue;
+            }
+            lines += field.lock(move.landed, 1 + piece);
+            pieces++;
+        }
+    });
+
+    cout << (lookahead ? "yes" : "no") << "\t" << threads << "\t" << 1000.0 * pieces / ms << "\t\t" << lines << "\t" << games << "\n";
+}
+
+// records a tetris game, then times playing it back headless: random key
+// presses until the well tops out, or the bot playing `botTicks` ticks
+void tetrisReplayBenchmark(bool bot, long long botTicks)
+{
+    Tetris::Game game(22);
+    Tetris::Recorder recorder(22, bot);
+    game.reset(22, bot);
+    srand(22);
+    Tetris::Input input = {};
+    while (!game.gameOver && (!bot || game.ticks < botTicks))
+    {
+        if (!bot && rand() % 8 == 0)
+            input = Tetris::unpackInput(rand() % 32); // any keys but the bot's
+        recorder.record(input);
+        game.tick(input);
+    }
+    const Tetris::Replay& replay = recorder.finish(game);
+
+    bool same = true;
+    const int repeats = bot ? 1 : 200;
+    double ms = timeMs(repeats, [&] { same &= Tetris::playReplay(replay, game); });
+
+    cout << (bot ? "bot" : "keys") << "\t" << replay.ticks << "\t" << replay.changes.size() << "\t"
+         << replay.ticks / ms / 1000 << "\t\t" << (same ? "yes" : "NO") << "\n";
+}
+
+int benchmarks()
+{
+    asteroidsCollisionBenchmark();
+    asteroidsSpawnBenchmark();
+    asteroidsKinematicsBenchmark();
+
+    // the default sweep; asteroidsStress() runs any other mix
+    asteroidsStressHeader();
+    struct { int rocks; float firePerTick; int ticks; } stress[] = {
+        { 15, 0.1f, 10000 }, { 500, 1, 5000 }, { 2000, 4, 2000 }, { 10000, 8, 500 },
+    };
+    for (auto &c : stress)
+        asteroidsStressBenchmark(c.rocks, c.firePerTick, c.ticks);
+
+    xonixFillBenchmark();
+    arkanoidBlockBenchmark();
+
+    cout << "arkanoid multi-ball (10000 blocks)\n";
+    cout << "balls\tM steps/s\tM swept steps/s\tblocks destroyed (swept)\n";
+    for (int count : {1, 100, 1000})
+        arkanoidMultiBallBenchmark(count);
+
+    cout << "xonix enemies (swept moves)\n";
+    cout << "enemies\tspeed\tM updates/s\tnew wall hits\n";
+    for (int count : {4, 100, 500, 1000})
+        for (int speed : {4, 40})
+            xonixEnemyBenchmark(count, speed);
+
+    cout << "xonix games in parallel\n";
+    cout << "games\tthreads\tM ticks/s\n";
+    int cores = max(1u, thread::hardware_concurrency());
+    for (int threads : {1, cores})
+        xonixParallelBenchmark(4 * cores, threads);
+
+    cout << "tetris bot\n";
+    cout << "lookahead\tthreads\tpieces/s\tlines\tgames\n";
+    for (bool lookahead : {false, true})
+        for (int threads : {1, cores})
+            tetrisBotBenchmark(lookahead, threads);
+
+    cout << "tetris replay\n";
+    cout << "player\tticks\tchanges\tM ticks/s\tsame end\n";
+    tetrisReplayBenchmark(false, 0);
+    tetrisReplayBenchmark(true, 20000);
+    return 0;
+}
+
+// one headless asteroids stress run with the rock count, fire rate and
+// tick count typed in, so any mix can be measured without rebuilding
+int asteroidsStress()
+{
+    int rocks, ticks;
+    float firePerTick;
+    cout << "rocks, bullets fired per tick, ticks (e.g. 2000 4 2000): ";
+    if (!(cin >> rocks >> firePerTick >> ticks) || rocks < 0 || firePerTick < 0 || ticks < 1)
+    {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cout << "expected three numbers, at least 1 tick\n";
+        return 1;
+    }
+
+    asteroidsStressHeader();
+    asteroidsStressBenchmark(rocks, firePerTick, ticks);
+    return 0;
+}
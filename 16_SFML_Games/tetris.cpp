@@ -1,40 +1,26 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <time.h>
+#include <thread>
+#include "TetrisGame.h"
+#include "TetrisReplay.h"
+#include "TickScheduler.h"
 using namespace sf;
 
-const int M = 20;
-const int N = 10;
+const int M = Tetris::ROWS;
+const int N = Tetris::COLS;
 
-int field[M][N] = {0};
+// each game is saved here when it ends, and tetrisReplay() plays it back
+const char* REPLAY_PATH = "tetris-replay.txt";
 
-struct Point
-{int x,y;} a[4], b[4];
-
-int figures[7][4] =
-{
-    1,3,5,7, // I
-    2,4,5,7, // Z
-    3,5,4,6, // S
-    3,5,4,7, // T
-    2,3,5,7, // L
-    3,5,7,6, // J
-    2,3,4,5, // O
-};
-
-bool check()
-{
-   for (int i=0;i<4;i++)
-      if (a[i].x<0 || a[i].x>=N || a[i].y>=M) return 0;
-      else if (field[a[i].y][a[i].x]) return 0;
-
-   return 1;
-};
+using Tetris::Point;
+Point a[4]; // the cells of the piece, for drawing
 
 
 int tetris()
 {
-    srand(time(0));     
-
     RenderWindow window(VideoMode(320, 480), "The Game!");
 
     Texture t1,t2,t3;
@@ -44,16 +30,26 @@ int tetris()
 
     Sprite s(t1), background(t2), frame(t3);
 
-    int dx=0; bool rotate=0; int colorNum=1;
-    float timer=0,delay=0.3; 
+    // B hands the game to the bot, which plays on its own (looking at the
+    // next piece too) until B is pressed again
+    Tetris::ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    uint32_t seed = (uint32_t)time(0);
+    Tetris::Game game(seed, &pool);
+    Tetris::Recorder recorder(seed);
+
+    // keys that went down since the last tick count for that tick even if
+    // they were let go again before it
+    Tetris::Input pressed = {};
 
-    Clock clock;
+    // the loop sleeps until the next tick is due, then reads the keys, runs
+    // the tick and draws; so it uses next to no CPU, draws at most once per
+    // tick, and a key is acted on by the first tick after it goes down
+    TickScheduler scheduler(Tetris::Game::TICKS_PER_SECOND);
 
     while (window.isOpen())
     {
-        float time = clock.getElapsedTime().asSeconds();
-        clock.restart();
-        timer+=time;
+        std::this_thread::sleep_until(scheduler.nextTick());
+        int ticks = scheduler.due(TickScheduler::Clock::now());
 
         Event e;
         while (window.pollEvent(e))
@@ -62,84 +58,61 @@ int tetris()
                 window.close();
 
             if (e.type == Event::KeyPressed)
-              if (e.key.code==Keyboard::Up) rotate=true;
-              else if (e.key.code==Keyboard::Left) dx=-1;
-              else if (e.key.code==Keyboard::Right) dx=1;
+            {
+              if (e.key.code==Keyboard::Up) pressed.rotateRight=true;
+              else if (e.key.code==Keyboard::Z) pressed.rotateLeft=true;
+              else if (e.key.code==Keyboard::Left) pressed.left=true;
+              else if (e.key.code==Keyboard::Right) pressed.right=true;
+              else if (e.key.code==Keyboard::B) pressed.bot=true;
+            }
         }
 
-    if (Keyboard::isKeyPressed(Keyboard::Down)) delay=0.05;
-
-    //// <- Move -> ///
-    for (int i=0;i<4;i++)  { b[i]=a[i]; a[i].x+=dx; }
-    if (!check()) for (int i=0;i<4;i++) a[i]=b[i];
-
-    //////Rotate//////
-    if (rotate)
-      {
-        Point p = a[1]; //center of rotation
-        for (int i=0;i<4;i++)
-          {
-            int x = a[i].y-p.y;
-            int y = a[i].x-p.x;
-            a[i].x = p.x - x;
-            a[i].y = p.y + y;
-           }
-           if (!check()) for (int i=0;i<4;i++) a[i]=b[i];
-      }
-
     ///////Tick//////
-    if (timer>delay)
+    for (int t=0;t<ticks;t++)
       {
-        for (int i=0;i<4;i++) { b[i]=a[i]; a[i].y+=1; }
-
-        if (!check())
-        {
-         for (int i=0;i<4;i++) field[b[i].y][b[i].x]=colorNum;
-
-         colorNum=1+rand()%7;
-         int n=rand()%7;
-         for (int i=0;i<4;i++)
-           {
-            a[i].x = figures[n][i] % 2;
-            a[i].y = figures[n][i] / 2;
-           }
-        }
-
-         timer=0;
+        Tetris::Input input = {
+            pressed.left || Keyboard::isKeyPressed(Keyboard::Left),
+            pressed.right || Keyboard::isKeyPressed(Keyboard::Right),
+            pressed.rotateRight || Keyboard::isKeyPressed(Keyboard::Up),
+            pressed.rotateLeft || Keyboard::isKeyPressed(Keyboard::Z),
+            Keyboard::isKeyPressed(Keyboard::Down),
+            pressed.bot || Keyboard::isKeyPressed(Keyboard::B),
+        };
+        pressed = Tetris::Input{};
+
+        recorder.record(input);
+        game.tick(input);
+
+        if (game.gameOver)
+          {
+            Tetris::saveReplay(REPLAY_PATH, recorder.finish(game));
+            bool bot=game.botPlays;
+            seed++;
+            game.reset(seed, bot);
+            recorder=Tetris::Recorder(seed, bot);
+          }
       }
 
-    ///////check lines//////////
-    int k=M-1;
-    for (int i=M-1;i>0;i--)
-    {
-        int count=0;
-        for (int j=0;j<N;j++)
-        {
-            if (field[i][j]) count++;
-            field[k][j]=field[i][j];
-        }
-        if (count<N) k--;
-    }
-
-    dx=0; rotate=0; delay=0.3;
+    if (ticks==0) continue; // woke early, nothing new to draw
 
     /////////draw//////////
-    window.clear(Color::White);    
+    window.clear(Color::White);
     window.draw(background);
-          
+
     for (int i=0;i<M;i++)
      for (int j=0;j<N;j++)
        {
-         if (field[i][j]==0) continue;
-         s.setTextureRect(IntRect(field[i][j]*18,0,18,18));
+         if (game.field.cell(i,j)==0) continue;
+         s.setTextureRect(IntRect(game.field.cell(i,j)*18,0,18,18));
          s.setPosition(j*18,i*18);
          s.move(28,31); //offset
          window.draw(s);
        }
 
+    Tetris::cellsOf(game.piece, a);
     for (int i=0;i<4;i++)
       {
-        s.setTextureRect(IntRect(colorNum*18,0,18,18));
+        s.setTextureRect(IntRect(game.colour()*18,0,18,18));
         s.setPosition(a[i].x*18,a[i].y*18);
         s.move(28,31); //offset
         window.draw(s);
@@ -149,5 +122,30 @@ int tetris()
     window.display();
     }
 
+    // a game still going when the window closes is saved too
+    Tetris::saveReplay(REPLAY_PATH, recorder.finish(game));
     return 0;
 }
+
+// plays the last saved game again without a window and checks it ends the
+// same way; for regression checks and for profiling the game logic alone
+int tetrisReplay()
+{
+    Tetris::Replay replay;
+    if (!Tetris::loadReplay(REPLAY_PATH, replay))
+    {
+        std::cout << "no replay in " << REPLAY_PATH << "\n";
+        return 1;
+    }
+
+    Tetris::Game game;
+    auto start = std::chrono::steady_clock::now();
+    bool same = Tetris::playReplay(replay, game);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "replayed " << game.ticks << " ticks in " << elapsed.count() * 1000 << " ms"
+              << " (" << game.ticks / std::max(elapsed.count(), 1e-9) / 1e6 << " M ticks/s)\n";
+    std::cout << "score " << game.score << ", lines " << game.lines << ": "
+              << (same ? "matches the recording" : "DIFFERS from the recording") << "\n";
+    return same ? 0 : 1;
+}
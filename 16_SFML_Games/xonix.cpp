@@ -7,76 +7,32 @@ using namespace sf;
 const int HEIGHT = 25;
 const int WIDTH = 40;
 const int tileSize = 18; 
+const int ENEMY_COUNT = 4;
 
-#include"Grid.h"
-
-Grid grid;
-
-struct Enemy
-{
-    int x,y,dx,dy;
-
-  Enemy()
-   {
-    x=y=300;
-    dx=4-rand()%8;
-    dy=4-rand()%8;
-   }
-
-  void move()
-   { 
-    x+=dx; if (grid.pointInWall(y,x)) {dx=-dx; x+=dx;}
-    y+=dy; if (grid.pointInWall(y, x)) {dy=-dy; y+=dy;}
-   }
-};
-
-class StopWatch {
-	Clock clock;
-    float targetTime;
-
-public:
-    StopWatch(float targetTime):targetTime(targetTime) {}
-
-    bool isTimeUp() { 
-        return clock.getElapsedTime().asSeconds() > targetTime;
-    }
-    void reset() {
-		clock.restart();
-	}
-};
-
-#include"Player.h"
-
-
-Player player;
-const int enemyCount = 4;
-Enemy enemies[enemyCount];
-bool gameOver = false;
-
-void gameReset() {
-    grid.clear();
-	player.reset();
-    gameOver = false;
-}
-
-bool enemyTouchesNewWall() {
-	for (int i=0;i<enemyCount;i++)
-		if (grid.pointInNewWall(enemies[i].y,enemies[i].x)) return true;
-	return false;
-}
-
-void moveEnemies() {
-	for (int i=0;i<enemyCount;i++) enemies[i].move();
-}
+#include"XonixGame.h"
 
 class Screen {
     RenderWindow window;
     Texture t1, t2, t3;
     //Sprite sTile(t1), sGameover(t2), sEnemy(t3);
     Sprite sTile, sGameover, sEnemy;
+    VertexArray board; // one quad per grid cell, only changed cells are rewritten
+    XonixGame& game;
+
+    void updateTile(int y, int x) {
+        Grid& grid = game.grid;
+        Vertex* quad = &board[(y * WIDTH + x) * 4];
+        float left = grid.isNewWall(y, x) ? 54 : 0; // green or blue tile
+        Color colour = grid.isEmpty(y, x) ? Color::Transparent : Color::White;
+        const float corner[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+        for (int k = 0; k < 4; k++) {
+            quad[k].texCoords = Vector2f(left + corner[k][0] * tileSize, corner[k][1] * tileSize);
+            quad[k].color = colour;
+        }
+    }
 public:
 
-    Screen():window(VideoMode(WIDTH* tileSize, HEIGHT* tileSize), "Xonix Game!") {
+    Screen(XonixGame& game):window(VideoMode(WIDTH* tileSize, HEIGHT* tileSize), "Xonix Game!"), game(game) {
      
         window.setFramerateLimit(60);
 
@@ -90,43 +46,45 @@ public:
 
         sGameover.setPosition(100, 100);
         sEnemy.setOrigin(20, 20);
+
+        board.setPrimitiveType(Quads);
+        board.resize(HEIGHT * WIDTH * 4);
+        for (int i = 0; i < HEIGHT; i++)
+            for (int j = 0; j < WIDTH; j++) {
+                Vertex* quad = &board[(i * WIDTH + j) * 4];
+                quad[0].position = Vector2f(j * tileSize, i * tileSize);
+                quad[1].position = Vector2f((j + 1) * tileSize, i * tileSize);
+                quad[2].position = Vector2f((j + 1) * tileSize, (i + 1) * tileSize);
+                quad[3].position = Vector2f(j * tileSize, (i + 1) * tileSize);
+            }
     }
 
     void drawFrame() {
         /////////draw//////////
         window.clear();
 
-        IntRect blueTile(0, 0, tileSize, tileSize);
-        IntRect greenTile(54, 0, tileSize, tileSize);
         IntRect redTile(36, 0, tileSize, tileSize);
 
-        //draw wall times
-        for (int i = 0; i < HEIGHT; i++)
-            for (int j = 0; j < WIDTH; j++)
-            {
-                if (grid.isEmpty(i, j))   continue;
-                if (grid.isWall(i, j))    sTile.setTextureRect(blueTile);
-                if (grid.isNewWall(i, j)) sTile.setTextureRect(greenTile);
-                sTile.setPosition(j * tileSize, i * tileSize);
-                window.draw(sTile);
-            }
+        //draw wall tiles, refreshing only the cells the grid changed
+        game.grid.takeDirtyCells([this](int y, int x) { updateTile(y, x); });
+        window.draw(board, RenderStates(&t1));
 
         //draw player
         sTile.setTextureRect(redTile);
-        sTile.setPosition(player.x * tileSize, player.y * tileSize);
+        sTile.setPosition(game.player.x * tileSize, game.player.y * tileSize);
         window.draw(sTile);
 
 
         sEnemy.rotate(10);
 
         //draw enemy
-        for (int i = 0; i < enemyCount; i++)
+        for (auto& e : game.enemies)
         {
-            sEnemy.setPosition(enemies[i].x, enemies[i].y);
+            sEnemy.setPosition(e.x, e.y);
             window.draw(sEnemy);
         }
 
-        if (gameOver) window.draw(sGameover);
+        if (game.gameOver) window.draw(sGameover);
 
         window.display();
     }
@@ -153,71 +111,31 @@ public:
     }
 };
 
-void controlPlayer(){
-    if (Keyboard::isKeyPressed(Keyboard::Left)) player.goLeft();
-    if (Keyboard::isKeyPressed(Keyboard::Right))   player.goRight();
-    if (Keyboard::isKeyPressed(Keyboard::Up))  player.goUp();
-    if (Keyboard::isKeyPressed(Keyboard::Down))  player.goDown();
-}
-
-void movePlayer(bool& playerTouchedNewWall){
-
-        player.move();
-
-        playerTouchedNewWall = grid.cellIsNewWall(player.y, player.x);
-
-        grid.newWall(player.y, player.x);
+XonixInput readKeyboard() {
+    XonixInput input;
+    input.left = Keyboard::isKeyPressed(Keyboard::Left);
+    input.right = Keyboard::isKeyPressed(Keyboard::Right);
+    input.up = Keyboard::isKeyPressed(Keyboard::Up);
+    input.down = Keyboard::isKeyPressed(Keyboard::Down);
+    return input;
 }
 
-void playerCompletesLoop() {
-    bool playerTouchesFilledWall = grid.isWall(player.y, player.x);
-
-    if (playerTouchesFilledWall)
-    {
-        player.stop();
-
-        for (int i = 0; i < enemyCount; i++)
-            grid.markConnectedCellsNotToBeFilled(enemies[i].y / tileSize, enemies[i].x / tileSize);
-
-        grid.fillEmptyCells();
-    }
-}
 int xonix()
 {
-    srand(time(0));
-
-    Screen screen;
-    gameReset();
-
-    const float TIME_BETWEEN_PLAYER_MOVES = 0.07;
-    StopWatch playerMoveTimer(TIME_BETWEEN_PLAYER_MOVES);
+    XonixGame game(ENEMY_COUNT, (uint32_t)time(0), HEIGHT, WIDTH, tileSize);
+    Screen screen(game);
 
     while (screen.isOpen())
     {
 
         if (screen.handleEvents() == true) 
-            gameReset();
+            game.reset();
 
-        if (gameOver) continue;
+        if (game.gameOver) continue;
 
-        controlPlayer();
-
-        bool playerTouchedNewWall = false;
-      
-        if (playerMoveTimer.isTimeUp()) {
-            movePlayer(playerTouchedNewWall);
-            playerMoveTimer.reset();
-        }
-
-        moveEnemies();
-
-        playerCompletesLoop();
-
-        gameOver = enemyTouchesNewWall() || playerTouchedNewWall;
+        game.tick(readKeyboard());
 
         screen.drawFrame();
-
-      
     }
 
     return 0;
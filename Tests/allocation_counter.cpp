@@ -0,0 +1,53 @@
+//
+// allocation_counter.cpp
+//
+
+#include "pch.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "allocation_counter.h"
+
+// kept in a file of its own so the compiler never sees a call to these
+// next to the free() inside them
+static std::atomic<bool> counting(false);
+static std::atomic<int> allocations(0);
+
+static void* allocate(std::size_t size)
+{
+	if (counting) allocations++;
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size)
+{
+	if (void* p = allocate(size)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	if (void* p = allocate(size)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+CountAllocations::CountAllocations()
+{
+	allocations = 0;
+	counting = true;
+}
+
+CountAllocations::~CountAllocations() { counting = false; }
+
+int CountAllocations::count() const { return allocations; }
@@ -0,0 +1,17 @@
+//
+// allocation_counter.h
+//
+
+#pragma once
+
+// Counts the heap allocations made while it is alive. The global operator
+// new and delete are replaced in allocation_counter.cpp, every form of
+// them, so the rest of the test binary still pairs them up; outside a
+// counted stretch they are plain malloc and free.
+class CountAllocations {
+public:
+	CountAllocations();
+	~CountAllocations();
+
+	int count() const;
+};
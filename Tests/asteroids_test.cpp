@@ -0,0 +1,446 @@
+#include "pch.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <utility>
+#include <vector>
+#include "allocation_counter.h"
+#include"../16_SFML_Games/AsteroidsCollision.h"
+#include"../16_SFML_Games/AsteroidsKinematics.h"
+#include"../16_SFML_Games/AsteroidsPool.h"
+#include"../16_SFML_Games/AsteroidsWorld.h"
+
+using namespace Asteroids;
+
+TEST(SpatialHash, FindsEntityInSameCell) {
+
+	SpatialHash grid(1200, 800, 50);
+	grid.insert(7, 100, 100);
+
+	std::vector<int> found;
+	grid.query(110, 105, [&](int id) { found.push_back(id); });
+
+	ASSERT_EQ(1u, found.size());
+	EXPECT_EQ(7, found[0]);
+}
+
+TEST(SpatialHash, IgnoresFarEntity) {
+
+	SpatialHash grid(1200, 800, 50);
+	grid.insert(7, 600, 400);
+
+	int visits = 0;
+	grid.query(100, 100, [&](int) { visits++; });
+
+	EXPECT_EQ(0, visits);
+}
+
+TEST(SpatialHash, NeighboursWrapAroundScreenEdges) {
+
+	SpatialHash grid(1200, 800, 50);
+	grid.insert(1, 1190, 795);
+
+	int visits = 0;
+	grid.query(5, 5, [&](int) { visits++; });
+
+	EXPECT_EQ(1, visits);
+}
+
+TEST(SpatialHash, PositionsOutsidePlayfieldAreWrapped) {
+
+	SpatialHash grid(1200, 800, 50);
+	grid.insert(1, -3, 804);
+
+	int visits = 0;
+	grid.query(1199, 0, [&](int) { visits++; });
+
+	EXPECT_EQ(1, visits);
+}
+
+TEST(SpatialHash, TinyGridVisitsEachCellOnce) {
+
+	SpatialHash grid(100, 100, 50);
+	grid.insert(1, 10, 10);
+
+	int visits = 0;
+	grid.query(60, 60, [&](int) { visits++; });
+
+	EXPECT_EQ(1, visits);
+}
+
+TEST(SpatialHash, FindsSameCollisionsAsBruteForce) {
+
+	struct Body { float x, y, R; };
+	srand(1);
+	std::vector<Body> bodies(500);
+	for (auto& b : bodies)
+		b = Body{ float(rand() % 1200), float(rand() % 800), rand() % 2 ? 25.f : 10.f };
+
+	std::set<std::pair<int, int>> brute, hashed;
+	for (int i = 0; i < (int)bodies.size(); i++)
+		for (int j = 0; j < (int)bodies.size(); j++)
+			if (i != j && circlesOverlap(bodies[i].x, bodies[i].y, bodies[i].R, bodies[j].x, bodies[j].y, bodies[j].R))
+				brute.insert({ i, j });
+
+	SpatialHash grid(1200, 800, 50);
+	for (int i = 0; i < (int)bodies.size(); i++)
+		grid.insert(i, bodies[i].x, bodies[i].y);
+	for (int i = 0; i < (int)bodies.size(); i++)
+		grid.query(bodies[i].x, bodies[i].y, [&](int j) {
+			if (i != j && circlesOverlap(bodies[i].x, bodies[i].y, bodies[i].R, bodies[j].x, bodies[j].y, bodies[j].R))
+				hashed.insert({ i, j });
+		});
+
+	EXPECT_FALSE(brute.empty());
+	EXPECT_EQ(brute, hashed);
+}
+
+
+TEST(Pool, HandleFindsItemAfterSwapRemove) {
+
+	Pool<int> pool(4);
+	Handle a = pool.add(1);
+	Handle b = pool.add(2);
+	Handle c = pool.add(3);
+
+	pool.remove(a);
+
+	EXPECT_EQ(2, pool.size());
+	EXPECT_EQ(nullptr, pool.get(a));
+	EXPECT_EQ(2, *pool.get(b));
+	EXPECT_EQ(3, *pool.get(c));
+	EXPECT_EQ(3, pool[0]);
+}
+
+TEST(Pool, ReusedSlotDoesNotReviveStaleHandle) {
+
+	Pool<int> pool(1);
+	Handle a = pool.add(1);
+	pool.remove(a);
+	Handle b = pool.add(2);
+
+	EXPECT_EQ(a.slot, b.slot);
+	EXPECT_EQ(nullptr, pool.get(a));
+	EXPECT_EQ(2, *pool.get(b));
+}
+
+TEST(Pool, RefusesItemsBeyondCapacity) {
+
+	Pool<int> pool(2);
+	pool.add(1);
+	pool.add(2);
+
+	Handle h = pool.add(3);
+
+	EXPECT_TRUE(pool.full());
+	EXPECT_EQ(-1, h.slot);
+	EXPECT_EQ(nullptr, pool.get(h));
+	EXPECT_EQ(2, pool.size());
+}
+
+TEST(Pool, RemoveIfKeepsSurvivorsPacked) {
+
+	Pool<int> pool(8);
+	std::vector<Handle> handles;
+	for (int i = 0; i < 8; i++) handles.push_back(pool.add(i));
+
+	pool.removeIf([](int v) { return v % 2 == 0; });
+
+	EXPECT_EQ(4, pool.size());
+	for (int i = 0; i < 8; i++) {
+		if (i % 2) EXPECT_EQ(i, *pool.get(handles[i]));
+		else EXPECT_EQ(nullptr, pool.get(handles[i]));
+	}
+}
+
+TEST(World, BulletSplitsBigRockIntoTwoSmallOnes) {
+
+	World world(defaultAnimations());
+	Handle rock = world.spawnAsteroid(500, 400, 0);
+	world.p->x = 100; world.p->y = 100;
+	Handle b = world.fire();
+	world.bullets.get(b)->x = 505; world.bullets.get(b)->y = 400;
+
+	world.collide();
+
+	EXPECT_FALSE(world.asteroids.get(rock)->life);
+	EXPECT_FALSE(world.bullets.get(b)->life);
+	ASSERT_EQ(1, world.explosions.size());
+	EXPECT_EQ(Kind::Explosion, world.explosions[0].kind);
+	ASSERT_EQ(3, world.asteroids.size());
+	for (auto& a : world.asteroids)
+		if (&a != world.asteroids.get(rock)) {
+			EXPECT_EQ(15, a.R);
+			EXPECT_EQ(500, a.x);
+			EXPECT_EQ(400, a.y);
+		}
+
+	world.update();
+	EXPECT_EQ(2, world.asteroids.size());
+	EXPECT_EQ(nullptr, world.asteroids.get(rock));
+	EXPECT_TRUE(world.bullets.empty());
+}
+
+TEST(World, SmallRockIsNotSplit) {
+
+	World world(defaultAnimations());
+	world.spawnAsteroid(500, 400, 0, true);
+	world.p->x = 100; world.p->y = 100;
+	Handle b = world.fire();
+	world.bullets.get(b)->x = 500; world.bullets.get(b)->y = 400;
+
+	world.collide();
+	world.update();
+
+	EXPECT_TRUE(world.asteroids.empty());
+	EXPECT_EQ(1, world.explosions.size());
+}
+
+TEST(World, RockHittingPlayerResetsShip) {
+
+	World world(defaultAnimations());
+	Handle rock = world.spawnAsteroid(210, 200, 0);
+	world.p->dx = 3; world.p->dy = 1;
+
+	world.collide();
+
+	EXPECT_FALSE(world.asteroids.get(rock)->life);
+	EXPECT_EQ(1, world.explosions.size());
+	EXPECT_EQ(W / 2, world.p->x);
+	EXPECT_EQ(H / 2, world.p->y);
+	EXPECT_EQ(0, world.p->dx);
+	EXPECT_EQ(0, world.p->dy);
+}
+
+TEST(World, ExplosionDisappearsWhenAnimationEnds) {
+
+	World world(defaultAnimations());
+	world.spawnAsteroid(500, 400, 0, true);
+	world.p->x = 100; world.p->y = 100;
+	Handle b = world.fire();
+	world.bullets.get(b)->x = 500; world.bullets.get(b)->y = 400;
+	world.collide();
+
+	// 48 frames at 0.5 per tick
+	int ticks = 0;
+	while (!world.explosions.empty() && ticks < 1000) {
+		world.update();
+		ticks++;
+	}
+
+	EXPECT_EQ(96, ticks);
+}
+
+TEST(World, BulletDiesOffScreenAndRocksWrap) {
+
+	World world(defaultAnimations());
+	world.p->x = W - 2; world.p->y = 400; world.p->angle = 0;
+	world.fire();
+	Handle rock = world.spawnAsteroid(W, 10, 0);
+	world.asteroids.get(rock)->dx = 3; world.asteroids.get(rock)->dy = 0;
+
+	world.update();
+
+	EXPECT_TRUE(world.bullets.empty());
+	EXPECT_EQ(0, world.asteroids.get(rock)->x);
+}
+
+TEST(World, ThrustSwapsShipAnimation) {
+
+	World world(defaultAnimations());
+
+	world.p->thrust = true;
+	world.update();
+	EXPECT_EQ(40, world.p->anim.current().top);
+
+	world.p->thrust = false;
+	world.update();
+	EXPECT_EQ(0, world.p->anim.current().top);
+}
+
+// both checks the steady-state tests below rely on do see a buffer grow
+TEST(World, ReservedBytesGrowWithStorage) {
+
+	World world(defaultAnimations(), 1, 16);
+	size_t before = world.reservedBytes();
+	CountAllocations counter;
+	world.spawnRocks(200);
+	world.collide(); // more rocks in the hash than it has ever held
+
+	EXPECT_LT(0, counter.count());
+	EXPECT_LT(before, world.reservedBytes());
+}
+
+TEST(World, FiringBulletsDoesNotAllocate) {
+
+	World world(defaultAnimations());
+
+	size_t before = world.reservedBytes();
+	CountAllocations counter;
+	for (int i = 0; i < 100; i++)
+		world.fire();
+
+	EXPECT_EQ(0, counter.count());
+	EXPECT_EQ(100, world.bullets.size());
+	EXPECT_EQ(before, world.reservedBytes());
+}
+
+TEST(World, UpdatingAndSwappingShipAnimationDoesNotAllocate) {
+
+	World world(defaultAnimations());
+	for (int i = 0; i < 10; i++) {
+		world.p->angle = i * 36;
+		world.fire();
+	}
+
+	size_t before = world.reservedBytes();
+	CountAllocations counter;
+	for (int i = 0; i < 100; i++) {
+		world.p->thrust = i % 2;
+		world.update();
+	}
+
+	EXPECT_EQ(0, counter.count());
+	EXPECT_EQ(before, world.reservedBytes());
+}
+
+TEST(World, StepAppliesControls) {
+
+	World world(defaultAnimations());
+	Input in = {};
+
+	in.right = true;
+	in.fire = true;
+	world.step(in);
+
+	EXPECT_EQ(3, world.p->angle);
+	EXPECT_EQ(1, world.bullets.size());
+	EXPECT_EQ(1, world.ticks);
+
+	in = Input{};
+	in.left = true;
+	in.thrust = true;
+	world.step(in);
+
+	EXPECT_EQ(0, world.p->angle);
+	EXPECT_TRUE(world.p->thrust);
+	EXPECT_EQ(1, world.bullets.size());
+}
+
+// random controls from their own generator, so a run is fully determined by two seeds
+static uint64_t playRandomGame(uint32_t worldSeed, uint32_t inputSeed, int ticks, std::vector<Input>* record = nullptr)
+{
+	World world(defaultAnimations(), worldSeed);
+	world.spawnRocks(15);
+	Random pad(inputSeed);
+	for (int t = 0; t < ticks; t++) {
+		uint32_t bits = pad.next();
+		Input in = { (bits & 1) != 0, (bits & 2) != 0, (bits & 4) != 0, (bits & 0x38) == 0 };
+		if (record) record->push_back(in);
+		world.step(in);
+	}
+	return world.checksum();
+}
+
+TEST(World, SameSeedAndInputsGiveIdenticalRuns) {
+
+	EXPECT_EQ(playRandomGame(42, 7, 5000), playRandomGame(42, 7, 5000));
+	EXPECT_NE(playRandomGame(42, 7, 5000), playRandomGame(43, 7, 5000));
+	EXPECT_NE(playRandomGame(42, 7, 5000), playRandomGame(42, 8, 5000));
+}
+
+TEST(World, RecordedInputsReplayToSameState) {
+
+	std::vector<Input> inputs;
+	uint64_t live = playRandomGame(99, 3, 3000, &inputs);
+
+	World replay(defaultAnimations(), 99);
+	replay.spawnRocks(15);
+	for (auto& in : inputs)
+		replay.step(in);
+
+	EXPECT_EQ(live, replay.checksum());
+}
+
+// random rocks and bullets, with some parked exactly on or just past the edges
+static Motion randomMotion(int n, uint32_t seed)
+{
+	Random r(seed);
+	Motion m;
+	m.resize(n);
+	for (int i = 0; i < n; i++) {
+		m.x[i] = float(r.below(W * 100)) / 100;
+		m.y[i] = float(r.below(H * 100)) / 100;
+		m.dx[i] = float(r.below(1200)) / 100 - 6;
+		m.dy[i] = float(r.below(1200)) / 100 - 6;
+	}
+	m.x[0] = W; m.dx[0] = 0;
+	m.x[1] = 0; m.dx[1] = -0.5f;
+	m.y[2] = H; m.dy[2] = 0.25f;
+	m.y[3] = 0; m.dy[3] = 0;
+	return m;
+}
+
+static bool sameBits(const std::vector<float>& a, const std::vector<float>& b)
+{
+	return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+TEST(Kinematics, BatchedWrapMatchesScalarReference) {
+
+	for (int n : { 0, 3, 4, 7, 1001 }) {
+		Motion batched = randomMotion(n + 4, n), scalar = batched;
+
+		for (int tick = 0; tick < 50; tick++) {
+			moveAndWrap(batched.x.data(), batched.y.data(), batched.dx.data(), batched.dy.data(), n, W, H);
+			moveAndWrapScalar(scalar.x.data(), scalar.y.data(), scalar.dx.data(), scalar.dy.data(), 0, n, W, H);
+		}
+
+		EXPECT_TRUE(sameBits(scalar.x, batched.x)) << n;
+		EXPECT_TRUE(sameBits(scalar.y, batched.y)) << n;
+	}
+}
+
+TEST(Kinematics, BatchedCullMatchesScalarReference) {
+
+	for (int n : { 0, 3, 4, 7, 1001 }) {
+		Motion batched = randomMotion(n + 4, n + 100), scalar = batched;
+
+		for (int tick = 0; tick < 50; tick++) {
+			moveAndCull(batched.x.data(), batched.y.data(), batched.dx.data(), batched.dy.data(), batched.outside.data(), n, W, H);
+			moveAndCullScalar(scalar.x.data(), scalar.y.data(), scalar.dx.data(), scalar.dy.data(), scalar.outside.data(), 0, n, W, H);
+			ASSERT_EQ(scalar.outside, batched.outside) << n << " at tick " << tick;
+		}
+
+		EXPECT_TRUE(sameBits(scalar.x, batched.x)) << n;
+		EXPECT_TRUE(sameBits(scalar.y, batched.y)) << n;
+	}
+}
+
+TEST(Kinematics, RockWrapsToOppositeEdge) {
+
+	float x = W - 1, y = 1, dx = 2, dy = -2;
+
+	moveAndWrap(&x, &y, &dx, &dy, 1, W, H);
+
+	EXPECT_EQ(0, x);
+	EXPECT_EQ(H, y);
+}
+
+TEST(World, BulletVelocityIsFixedWhenFired) {
+
+	World world(defaultAnimations());
+	world.p->angle = 90;
+	Handle h = world.fire();
+	bullet* b = world.bullets.get(h);
+
+	EXPECT_NEAR(0, b->dx, 1e-3);
+	EXPECT_NEAR(6, b->dy, 1e-3);
+
+	float x = b->x, y = b->y;
+	world.update();
+	b = world.bullets.get(h);
+	EXPECT_EQ(x + b->dx, b->x);
+	EXPECT_EQ(y + b->dy, b->y);
+}
@@ -1,11 +1,15 @@
 #include "pch.h"
 
+#include <cstdlib>
+
 const int HEIGHT = 25;
 const int WIDTH = 40;
 const int tileSize = 18;
 
 #include"../16_SFML_Games/Grid.h"
+#include"../16_SFML_Games/BitGrid.h"
 #include"../16_SFML_Games/Player.h"
+#include"../16_SFML_Games/XonixEnemy.h"
 
 
 TEST(Grid, HasWallsAndInterior) {
@@ -111,6 +115,336 @@ TEST(Grid, GridsIsFilledWithHorizAndVertWall) {
 
 }
 
+TEST(Grid, SizeIsChosenAtConstruction) {
+
+	Grid grid(100, 300, 10);
+
+	EXPECT_EQ(100, grid.height());
+	EXPECT_EQ(300, grid.width());
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(99, 299));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(0, 150));
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(98, 298));
+	EXPECT_TRUE(grid.pointInWall(995, 5));
+	EXPECT_FALSE(grid.pointInWall(985, 15));
+}
+
+TEST(Grid, TilesAreOneByteEach) {
+
+	EXPECT_EQ(1u, sizeof(Grid::tile));
+}
+
+TEST(Grid, LargeBoardCapture) {
+
+	const int size = 4096;
+	Grid grid(size, size, 1);
+
+	for (int y = 1; y < size - 1; y++)
+		grid.newWall(y, size / 3);
+
+	grid.markConnectedCellsNotToBeFilled(size / 2, size / 2);
+	grid.fillEmptyCells();
+
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(size / 2, size / 3 - 1));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(size / 2, size / 3));
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(size / 2, size / 3 + 1));
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(size - 2, size - 2));
+}
+
+TEST(Grid, EnemiesOnBothSidesKeepBothAreas) {
+
+	Grid grid;
+
+	for (int y = 1; y < HEIGHT - 1; y++)
+		grid.newWall(y, 20);
+
+	grid.markConnectedCellsNotToBeFilled(std::vector<Seed>{ Seed{ 5, 5 }, Seed{ 5, 30 } });
+
+	grid.fillEmptyCells();
+
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(1, 1));
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(23, 38));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(10, 20));
+}
+
+TEST(Grid, WallCountIsKeptUpToDate) {
+
+	srand(5);
+	Grid grid(30, 50, 1);
+
+	for (int capture = 0; capture < 10; capture++) {
+		for (int i = 0; i < 200; i++)
+			grid.newWall(rand() % 30, rand() % 50);
+		grid.markConnectedCellsNotToBeFilled(std::vector<Seed>{ Seed{ 1 + rand() % 28, 1 + rand() % 48 } });
+		grid.fillEmptyCells();
+		if (capture == 6) grid.clear();
+
+		int walls = 0;
+		for (int y = 0; y < 30; y++)
+			for (int x = 0; x < 50; x++)
+				if (grid.isWall(y, x)) walls++;
+		ASSERT_EQ(walls, grid.wallCount());
+	}
+}
+
+TEST(Grid, ReportsOnlyChangedCells) {
+
+	Grid grid;
+	std::vector<Seed> changed;
+	auto collect = [&changed](int y, int x) { changed.push_back(Seed{ y, x }); };
+
+	grid.takeDirtyCells(collect);
+	EXPECT_EQ(size_t(HEIGHT * WIDTH), changed.size()); // a new board is drawn in full
+
+	changed.clear();
+	grid.takeDirtyCells(collect);
+	EXPECT_TRUE(changed.empty());
+
+	grid.newWall(1, 2);
+	grid.newWall(1, 2);
+	grid.newWall(0, 5); // already wall, so unchanged
+	grid.takeDirtyCells(collect);
+	ASSERT_EQ(1u, changed.size());
+	EXPECT_EQ(1, changed[0].y);
+	EXPECT_EQ(2, changed[0].x);
+
+	// closing off the top left corner changes the new wall and the one cell behind it
+	changed.clear();
+	grid.newWall(2, 1);
+	grid.newWall(2, 2);
+	grid.newWall(1, 3);
+	grid.takeDirtyCells([](int, int) {});
+	grid.markConnectedCellsNotToBeFilled(10, 10);
+	grid.fillEmptyCells();
+	grid.takeDirtyCells(collect);
+	EXPECT_EQ(5u, changed.size());
+
+	changed.clear();
+	grid.clear();
+	grid.takeDirtyCells(collect);
+	EXPECT_EQ(size_t(HEIGHT * WIDTH), changed.size());
+}
+
+// a one tile wall at column 7 (pixels 126 to 143), with both sides left open
+Grid gridWithWallColumn() {
+	Grid grid;
+	for (int y = 1; y < HEIGHT - 1; y++)
+		grid.newWall(y, 7);
+	grid.markConnectedCellsNotToBeFilled(std::vector<Seed>{ Seed{ 10, 3 }, Seed{ 10, 20 } });
+	grid.fillEmptyCells();
+	return grid;
+}
+
+TEST(Enemy, FastEnemyBouncesOffThinWall) {
+
+	Grid grid = gridWithWallColumn();
+	Enemy enemy(100, 200);
+	enemy.dx = 50; // would land at 150, past the wall
+	enemy.dy = 0;
+
+	enemy.move(grid);
+
+	EXPECT_EQ(100, enemy.x);
+	EXPECT_EQ(-50, enemy.dx);
+
+	enemy.move(grid);
+	EXPECT_EQ(50, enemy.x);
+}
+
+TEST(Enemy, FastEnemyBouncesOffBorder) {
+
+	Grid grid;
+	Enemy enemy(30, 100);
+	enemy.dx = 0;
+	enemy.dy = -200;
+
+	enemy.move(grid);
+
+	EXPECT_EQ(100, enemy.y);
+	EXPECT_EQ(200, enemy.dy);
+}
+
+TEST(Enemy, DetectsNewWallItJumpsOver) {
+
+	Grid grid;
+	for (int y = 1; y < HEIGHT - 1; y++)
+		grid.newWall(y, 7);
+	Enemy enemy(100, 200);
+	enemy.dx = 50;
+	enemy.dy = 0;
+
+	enemy.move(grid);
+
+	EXPECT_EQ(150, enemy.x);
+	EXPECT_FALSE(grid.pointInNewWall(enemy.y, enemy.x));
+	EXPECT_TRUE(enemy.touchesNewWall(grid));
+
+	enemy.move(grid);
+	EXPECT_FALSE(enemy.touchesNewWall(grid));
+}
+
+TEST(Enemy, SlowEnemyMovesAsBefore) {
+
+	Grid grid;
+	Enemy enemy(20, 300);
+	enemy.dx = -3;
+	enemy.dy = 4;
+
+	enemy.move(grid); // 17 is in the border, so it bounces back
+	EXPECT_EQ(20, enemy.x);
+	EXPECT_EQ(3, enemy.dx);
+	EXPECT_EQ(304, enemy.y);
+}
+
+TEST(FloodFill, LargeBoardDoesNotOverflowStack) {
+
+	const int size = 2048;
+	std::vector<unsigned char> board(size * size, 0);
+
+	scanlineFill<unsigned char>(board.data(), size, size, { Seed{ size / 2, size / 2 } }, 0, 1);
+
+	EXPECT_EQ(std::vector<unsigned char>(size * size, 1), board);
+}
+
+TEST(FloodFill, MatchesCellByCellReference) {
+
+	const int h = 64, w = 80;
+	srand(3);
+	std::vector<int> board(h * w);
+	for (auto& c : board) c = rand() % 10 < 4;
+
+	std::vector<int> expected = board;
+	std::vector<Seed> todo = { Seed{ 10, 10 }, Seed{ 50, 70 } };
+	while (!todo.empty()) {
+		Seed s = todo.back();
+		todo.pop_back();
+		if (s.y < 0 || s.y >= h || s.x < 0 || s.x >= w || expected[s.y * w + s.x] != 0) continue;
+		expected[s.y * w + s.x] = 2;
+		todo.push_back(Seed{ s.y - 1, s.x });
+		todo.push_back(Seed{ s.y + 1, s.x });
+		todo.push_back(Seed{ s.y, s.x - 1 });
+		todo.push_back(Seed{ s.y, s.x + 1 });
+	}
+
+	scanlineFill(board.data(), h, w, { Seed{ 10, 10 }, Seed{ 50, 70 } }, 0, 2);
+
+	EXPECT_EQ(expected, board);
+}
+
+
+// the same scenarios against every Grid backend
+template<class T>
+class GridBackend : public ::testing::Test {};
+
+typedef ::testing::Types<Grid, BitGrid> GridBackends;
+TYPED_TEST_CASE(GridBackend, GridBackends);
+
+TYPED_TEST(GridBackend, HasWallsAndInterior) {
+
+	TypeParam grid;
+
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(0, 0));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(24, 39));
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(10, 10));
+	EXPECT_EQ(0.f, grid.capturedPercent());
+}
+
+TYPED_TEST(GridBackend, FillsAroundHorizAndVertWall) {
+
+	TypeParam grid;
+
+	for (int x = 1; x < 10; x++)
+		grid.newWall(10, x);
+	for (int y = 10; y < HEIGHT - 1; y++)
+		grid.newWall(y, 10);
+	EXPECT_EQ(Grid::tile::NEW_WALL, grid.cell(10, 10));
+
+	grid.markConnectedCellsNotToBeFilled(2, 2);
+	EXPECT_EQ(Grid::tile::NOT_TO_BE_FILLED, grid.cell(9, 38));
+
+	grid.fillEmptyCells();
+
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(11, 1));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(23, 9));
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(1, 1));
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(23, 38));
+
+	// 13 x 9 corner captured plus its 9 + 14 new wall cells, of 23 x 38 inside
+	EXPECT_FLOAT_EQ(100.f * (13 * 9 + 9 + 14) / (23 * 38), grid.capturedPercent());
+}
+
+TYPED_TEST(GridBackend, WideBoardSpansSeveralWords) {
+
+	TypeParam grid(5, 200, 1);
+
+	grid.newWall(1, 130);
+	grid.newWall(2, 130);
+	grid.newWall(3, 130);
+	grid.markConnectedCellsNotToBeFilled(2, 3);
+	grid.fillEmptyCells();
+
+	EXPECT_EQ(Grid::tile::EMPTY, grid.cell(2, 129));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(2, 130));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(2, 131));
+	EXPECT_EQ(Grid::tile::WALL, grid.cell(2, 198));
+	EXPECT_TRUE(grid.pointInWall(2, 199));
+}
+
+TYPED_TEST(GridBackend, LevelCompletesAtTarget) {
+
+	TypeParam grid;
+
+	// a vertical wall at column 30 captures inside columns 1 to 30, 30 of 38
+	for (int y = 1; y < HEIGHT - 1; y++)
+		grid.newWall(y, 30);
+	grid.markConnectedCellsNotToBeFilled(5, 35);
+	grid.fillEmptyCells();
+
+	EXPECT_FLOAT_EQ(100.f * 30 / 38, grid.capturedPercent());
+	EXPECT_TRUE(grid.levelComplete(75));
+	EXPECT_FALSE(grid.levelComplete(80));
+
+	grid.clear();
+	EXPECT_FALSE(grid.levelComplete());
+}
+
+// random wall drawing and captures applied to both backends, compared cell by cell
+TEST(GridBackend, BitPlanesMatchByteGrid) {
+
+	srand(11);
+	for (int round = 0; round < 20; round++) {
+		int h = 3 + rand() % 60, w = 3 + rand() % 150;
+		Grid bytes(h, w, 1);
+		BitGrid bits(h, w, 1);
+
+		for (int capture = 0; capture < 5; capture++) {
+			for (int i = 0; i < h * w / 4; i++) {
+				int y = rand() % h, x = rand() % w;
+				bytes.newWall(y, x);
+				bits.newWall(y, x);
+			}
+			std::vector<Seed> enemies;
+			for (int e = 0; e < 4; e++)
+				enemies.push_back(Seed{ 1 + rand() % (h - 2), 1 + rand() % (w - 2) });
+
+			bytes.markConnectedCellsNotToBeFilled(enemies);
+			bits.markConnectedCellsNotToBeFilled(enemies);
+			for (int y = 0; y < h; y++)
+				for (int x = 0; x < w; x++)
+					ASSERT_EQ(bytes.cell(y, x), bits.cell(y, x)) << h << "x" << w << " at " << y << "," << x;
+
+			bytes.fillEmptyCells();
+			bits.fillEmptyCells();
+			ASSERT_EQ(bytes.wallCount(), bits.wallCount());
+			ASSERT_FLOAT_EQ(bytes.capturedPercent(), bits.capturedPercent());
+
+			if (capture == 2) {
+				bytes.clear();
+				bits.clear();
+			}
+		}
+	}
+}
+
 
 TEST(Player, ConstrainedHorizontallyRight) {
 
@@ -0,0 +1,703 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+#include "../16_SFML_Games/TetrisAI.h"
+#include "../16_SFML_Games/TetrisField.h"
+#include "../16_SFML_Games/TetrisGame.h"
+#include "../16_SFML_Games/TetrisPiece.h"
+#include "../16_SFML_Games/TetrisReplay.h"
+#include "../16_SFML_Games/TickScheduler.h"
+
+using namespace Tetris;
+
+namespace {
+
+    const int figures[7][4] =
+    {
+        1,3,5,7, // I
+        2,4,5,7, // Z
+        3,5,4,6, // S
+        3,5,4,7, // T
+        2,3,5,7, // L
+        3,5,7,6, // J
+        2,3,4,5, // O
+    };
+
+    // the int array field, check() and "check lines" pass tetris.cpp had before the bitboard
+    struct ReferenceField {
+        int field[ROWS][COLS] = {};
+
+        bool check(const Point a[4]) const {
+            for (int i = 0; i < 4; i++)
+                if (a[i].x < 0 || a[i].x >= COLS || a[i].y >= ROWS) return false;
+                else if (field[a[i].y][a[i].x]) return false;
+            return true;
+        }
+
+        void lock(const Point a[4], int colour) {
+            for (int i = 0; i < 4; i++) field[a[i].y][a[i].x] = colour;
+        }
+
+        void checkLines() {
+            int k = ROWS - 1;
+            for (int i = ROWS - 1; i > 0; i--) {
+                int count = 0;
+                for (int j = 0; j < COLS; j++) {
+                    if (field[i][j]) count++;
+                    field[k][j] = field[i][j];
+                }
+                if (count < COLS) k--;
+            }
+        }
+    };
+
+    void spawn(Point a[4], int n, int dx) {
+        for (int i = 0; i < 4; i++) {
+            a[i].x = figures[n][i] % 2 + dx;
+            a[i].y = figures[n][i] / 2;
+        }
+    }
+
+    // drops the piece from column offset dx; false if it doesn't fit at the top
+    bool drop(const ReferenceField& reference, int n, int dx, Point landed[4]) {
+        Point a[4];
+        spawn(a, n, dx);
+        if (!reference.check(a)) return false;
+        for (;;) {
+            for (int i = 0; i < 4; i++) { landed[i] = a[i]; a[i].y++; }
+            if (!reference.check(a)) return true;
+        }
+    }
+
+    void expectSameCells(const ReferenceField& reference, const Field& field) {
+        for (int y = 0; y < ROWS; y++)
+            for (int x = 0; x < COLS; x++)
+                ASSERT_EQ(reference.field[y][x], field.cell(y, x)) << y << "," << x;
+    }
+}
+
+TEST(TetrisField, StartsEmptyWithWalls) {
+    Field field;
+
+    EXPECT_TRUE(field.isFree(0, 0));
+    EXPECT_TRUE(field.isFree(ROWS - 1, COLS - 1));
+    EXPECT_TRUE(field.isFree(-3, 4)); // above the well is open
+    EXPECT_FALSE(field.isFree(5, -1));
+    EXPECT_FALSE(field.isFree(5, COLS));
+    EXPECT_FALSE(field.isFree(ROWS, 3));
+    EXPECT_FALSE(field.isFree(5, -100));
+    EXPECT_EQ(0, field.cell(10, 5));
+}
+
+TEST(TetrisField, FitsMatchesCheck) {
+    ReferenceField reference;
+    Field field;
+    srand(21);
+    for (int i = 0; i < 60; i++) {
+        Point p[4];
+        for (auto& c : p) { c.x = rand() % COLS; c.y = 8 + rand() % (ROWS - 8); }
+        if (reference.check(p)) {
+            reference.lock(p, 1 + i % 7);
+            field.lock(p, 1 + i % 7);
+        }
+    }
+
+    for (int y = 0; y <= ROWS; y++)
+        for (int x = -6; x < COLS + 6; x++) {
+            Point p[4] = { { x, y }, { x, y }, { x, y }, { x, y } };
+            ASSERT_EQ(reference.check(p), field.fits(p)) << y << "," << x;
+        }
+}
+
+TEST(TetrisField, LockClearsCompletedRowsOnly) {
+    Field field;
+    // two flat bars, columns 0-7
+    for (int x = 0; x + 3 < COLS; x += 4) {
+        Point bar[4] = { { x, 19 }, { x + 1, 19 }, { x + 2, 19 }, { x + 3, 19 } };
+        EXPECT_EQ(0, field.lock(bar, 1));
+    }
+    Point stub[4] = { { 8, 19 }, { 8, 18 }, { 8, 17 }, { 8, 16 } };
+    EXPECT_EQ(0, field.lock(stub, 2));
+    EXPECT_FALSE(field.rowFull(19));
+
+    // an upright I in the last column completes the bottom row
+    Point last[4] = { { 9, 19 }, { 9, 18 }, { 9, 17 }, { 9, 16 } };
+    EXPECT_EQ(1, field.lock(last, 3));
+
+    EXPECT_EQ(0, field.cell(19, 0));
+    EXPECT_EQ(2, field.cell(19, 8));
+    EXPECT_EQ(3, field.cell(19, 9));
+    EXPECT_EQ(2, field.cell(17, 8));
+    EXPECT_EQ(0, field.cell(16, 8));
+}
+
+// random pieces dropped straight down where they land lowest give the same
+// well, cell for cell and colour for colour, as the old per-frame line pass
+TEST(TetrisField, DropsMatchTheOldLinePass) {
+    srand(7);
+    int lines = 0;
+    for (int game = 0; game < 50; game++) {
+        ReferenceField reference;
+        Field field;
+
+        for (int piece = 0; piece < 400; piece++) {
+            int n = rand() % 7, colour = 1 + rand() % 7;
+            Point b[4];
+            int best = -1;
+            for (int dx = 0; dx < COLS - 1; dx++) {
+                Point landed[4];
+                if (!drop(reference, n, dx, landed)) continue;
+                int top = ROWS;
+                for (auto& c : landed) top = std::min(top, c.y);
+                if (top > best || (top == best && rand() % 2)) {
+                    best = top;
+                    std::copy(landed, landed + 4, b);
+                }
+            }
+            if (best < 0) break; // topped out
+
+            reference.lock(b, colour);
+            reference.checkLines();
+            lines += field.lock(b, colour);
+            expectSameCells(reference, field);
+            if (HasFatalFailure()) return;
+
+            // the old pass misbehaves once blocks reach the top rows; stop before then
+            bool nearTop = false;
+            for (int x = 0; x < COLS; x++) nearTop |= reference.field[3][x] != 0;
+            if (nearTop) break;
+        }
+    }
+    EXPECT_GT(lines, 50);
+}
+
+namespace {
+    bool sameCells(const Point a[4], const Point b[4]) {
+        for (int i = 0; i < 4; i++)
+            if (std::find_if(b, b + 4, [&](const Point& c) { return c.x == a[i].x && c.y == a[i].y; }) == b + 4) return false;
+        return true;
+    }
+
+    bool contains(const Point cells[4], Point c) {
+        return std::find_if(cells, cells + 4, [&](const Point& d) { return d.x == c.x && d.y == c.y; }) != cells + 4;
+    }
+
+    void block(Field& field, Point c) {
+        Point cells[4] = { c, c, c, c };
+        field.lock(cells, 1);
+    }
+}
+
+TEST(TetrisPiece, ShapesAreFourCellsMatchingTheirRowMasks) {
+    for (int n = 0; n < PIECE_COUNT; n++)
+        for (int r = 0; r < 4; r++) {
+            const Shape& shape = shapeTable.shapes[n][r];
+            unsigned char rows[4] = {};
+            for (int i = 0; i < 4; i++) {
+                const Point& c = shape.cells[i];
+                ASSERT_TRUE(c.x >= 0 && c.x < 4 && c.y >= 0 && c.y < 4) << n << "/" << r;
+                EXPECT_EQ(0, rows[c.y] & (1 << c.x)) << "cell twice in " << n << "/" << r;
+                rows[c.y] |= 1 << c.x;
+            }
+            for (int y = 0; y < 4; y++) EXPECT_EQ(rows[y], shape.rows[y]) << n << "/" << r;
+        }
+}
+
+TEST(TetrisPiece, TablesHoldTheGuidelineShapes) {
+    // the right-hand state of each piece, drawn in its box
+    const char* right[PIECE_COUNT][4] = {
+        { "..#.", "..#.", "..#.", "..#." }, // I
+        { "..#.", ".##.", ".#..", "...." }, // Z
+        { ".#..", ".##.", "..#.", "...." }, // S
+        { ".#..", ".##.", ".#..", "...." }, // T
+        { ".#..", ".#..", ".##.", "...." }, // L
+        { ".##.", ".#..", ".#..", "...." }, // J
+        { ".##.", ".##.", "....", "...." }, // O
+    };
+    for (int n = 0; n < PIECE_COUNT; n++)
+        for (int y = 0; y < 4; y++)
+            for (int x = 0; x < 4; x++)
+                EXPECT_EQ(right[n][y][x] == '#', (shapeTable.shapes[n][1].rows[y] >> x & 1) != 0) << n << " " << x << "," << y;
+}
+
+TEST(TetrisPiece, FourTurnsComeBackAround) {
+    Field field;
+    for (int n = 0; n < PIECE_COUNT; n++)
+        for (int dir = -1; dir <= 1; dir += 2) {
+            Piece p = { n, 0, 3, 8 };
+            Point start[4], cells[4];
+            cellsOf(p, start);
+            for (int turn = 0; turn < 4; turn++) ASSERT_TRUE(rotate(field, p, dir));
+            cellsOf(p, cells);
+            EXPECT_EQ(0, p.rotation);
+            EXPECT_TRUE(sameCells(start, cells)) << n;
+
+            // and a turn one way undoes a turn the other way, kicks included
+            for (int r = 0; r < 4; r++) {
+                Piece q = { n, r, 3, 8 };
+                ASSERT_TRUE(rotate(field, q, dir));
+                ASSERT_TRUE(rotate(field, q, -dir));
+                EXPECT_EQ(r, q.rotation);
+                EXPECT_EQ(3, q.x);
+                EXPECT_EQ(8, q.y);
+            }
+        }
+}
+
+// the kicks back from a state are the kicks into it, negated
+TEST(TetrisPiece, KicksAreSymmetric) {
+    for (int n = 0; n < PIECE_COUNT; n++)
+        for (int r = 0; r < 4; r++)
+            for (int k = 0; k < KICK_TESTS; k++) {
+                Piece from = { n, r, 0, 0 }, to = { n, (r + 1) % 4, 0, 0 };
+                Point there = kick(from, 1, k), back = kick(to, -1, k);
+                EXPECT_EQ(-there.x, back.x) << n << "/" << r << "/" << k;
+                EXPECT_EQ(-there.y, back.y) << n << "/" << r << "/" << k;
+            }
+}
+
+// For every piece, state, direction and kick test k: with a block in the
+// way of each earlier test, the turn lands exactly on test k
+TEST(TetrisPiece, EachKickIsTriedInOrder) {
+    for (int n = 0; n < PIECE_COUNT; n++)
+        for (int r = 0; r < 4; r++)
+            for (int dir = -1; dir <= 1; dir += 2)
+                for (int k = 0; k < KICK_TESTS; k++) {
+                    const Piece start = { n, r, 3, 8 };
+                    Piece target = { n, (r + (dir > 0 ? 1 : 3)) % 4, 3 + kick(start, dir, k).x, 8 + kick(start, dir, k).y };
+                    Point now[4], goal[4];
+                    cellsOf(start, now);
+                    cellsOf(target, goal);
+
+                    Field field;
+                    bool possible = true;
+                    for (int j = 0; j < k && possible; j++) {
+                        Piece earlier = { target.type, target.rotation, 3 + kick(start, dir, j).x, 8 + kick(start, dir, j).y };
+                        Point cells[4];
+                        cellsOf(earlier, cells);
+                        int i = 0;
+                        while (i < 4 && (contains(goal, cells[i]) || contains(now, cells[i]))) i++;
+                        if (i == 4) possible = false; // same cells as test k (an O, or a repeated offset)
+                        else block(field, cells[i]);
+                    }
+                    if (!possible) continue;
+
+                    Piece p = start;
+                    ASSERT_TRUE(rotate(field, p, dir)) << n << "/" << r << "/" << dir << "/" << k;
+                    EXPECT_EQ(target.rotation, p.rotation);
+                    EXPECT_EQ(target.x, p.x) << n << "/" << r << "/" << dir << "/" << k;
+                    EXPECT_EQ(target.y, p.y) << n << "/" << r << "/" << dir << "/" << k;
+                }
+}
+
+TEST(TetrisPiece, TurnFailsWhenEveryKickIsBlocked) {
+    for (int n = 0; n < PIECE_COUNT - 1; n++) // an O always turns in place
+        for (int r = 0; r < 4; r++)
+            for (int dir = -1; dir <= 1; dir += 2) {
+                const Piece start = { n, r, 3, 8 };
+                Point now[4];
+                cellsOf(start, now);
+
+                Field field;
+                for (int k = 0; k < KICK_TESTS; k++) {
+                    Piece test = { n, (r + (dir > 0 ? 1 : 3)) % 4, 3 + kick(start, dir, k).x, 8 + kick(start, dir, k).y };
+                    Point cells[4];
+                    cellsOf(test, cells);
+                    for (auto& c : cells)
+                        if (!contains(now, c)) { block(field, c); break; }
+                }
+
+                Piece p = start;
+                EXPECT_FALSE(rotate(field, p, dir)) << n << "/" << r << "/" << dir;
+                EXPECT_EQ(r, p.rotation);
+                EXPECT_EQ(3, p.x);
+                EXPECT_EQ(8, p.y);
+            }
+}
+
+TEST(TetrisPiece, WallsKickPiecesBackIn) {
+    Field field;
+    // an upright I against the left wall turns flat by moving right
+    Piece p = { I, 3, -1, 5 };
+    ASSERT_TRUE(fits(field, p));
+    ASSERT_TRUE(rotate(field, p, 1));
+    Point cells[4];
+    cellsOf(p, cells);
+    for (auto& c : cells) EXPECT_GE(c.x, 0);
+    EXPECT_TRUE(field.fits(cells));
+
+    // a T on the floor turning
+    Piece t = { T, 0, 3, ROWS - 2 };
+    ASSERT_TRUE(fits(field, t));
+    EXPECT_TRUE(rotate(field, t, -1));
+    EXPECT_TRUE(fits(field, t));
+
+    // the mask test agrees with the cell test everywhere near the walls and floor
+    for (int n = 0; n < PIECE_COUNT; n++)
+        for (int r = 0; r < 4; r++)
+            for (int y = -3; y <= ROWS; y++)
+                for (int x = -6; x <= COLS + 1; x++) {
+                    Piece q = { n, r, x, y };
+                    cellsOf(q, cells);
+                    ASSERT_EQ(field.fits(cells), fits(field, q)) << n << "/" << r << " " << x << "," << y;
+                }
+}
+
+TEST(TetrisBot, EvaluateCountsHolesHeightAndBumpiness) {
+    Field field;
+    Weights holes{ 0, 0, 1, 0 }, height{ 1, 0, 0, 0 }, bumpiness{ 0, 0, 0, 1 };
+    EXPECT_EQ(0, evaluate(field, 0, holes));
+    EXPECT_EQ(0, evaluate(field, 0, height));
+
+    // a flat S at the bottom left leaves one hole under its top row
+    Point s[4] = { { 1, 18 }, { 2, 18 }, { 0, 19 }, { 1, 19 } };
+    field.lock(s, 1);
+    EXPECT_EQ(1, evaluate(field, 0, holes));
+    EXPECT_EQ(1 + 2 + 2, evaluate(field, 0, height));
+    EXPECT_EQ(1 + 0 + 2, evaluate(field, 0, bumpiness));
+    EXPECT_EQ(3, evaluate(field, 3, Weights{ 0, 1, 0, 0 }));
+}
+
+TEST(TetrisBot, PlacementsRestInsideTheWell) {
+    Field field;
+    Point stub[4] = { { 4, 19 }, { 4, 18 }, { 5, 19 }, { 6, 19 } };
+    field.lock(stub, 1);
+
+    std::vector<Placement> found;
+    for (int n = 0; n < PIECE_COUNT; n++) {
+        placements(field, n, found);
+        ASSERT_FALSE(found.empty());
+        for (auto& p : found) {
+            EXPECT_TRUE(fits(field, p.start));
+            EXPECT_TRUE(field.fits(p.landed));
+            Point below[4];
+            for (int i = 0; i < 4; i++) below[i] = Point{ p.landed[i].x, p.landed[i].y + 1 };
+            EXPECT_FALSE(field.fits(below));
+        }
+    }
+
+    // an upright I can go in every column
+    placements(Field(), I, found);
+    bool column[COLS] = {};
+    for (auto& p : found)
+        if (p.landed[0].x == p.landed[3].x) column[p.landed[0].x] = true;
+    for (int x = 0; x < COLS; x++) EXPECT_TRUE(column[x]) << x;
+}
+
+TEST(TetrisBot, PoolRunsEveryIndexOnce) {
+    ThreadPool pool(3);
+    for (int round = 0; round < 50; round++) {
+        std::vector<std::atomic<int>> seen(round * 7);
+        for (auto& s : seen) s = 0;
+        pool.forEach((int)seen.size(), [&](int i) { seen[i]++; });
+        for (auto& s : seen) ASSERT_EQ(1, s.load());
+    }
+}
+
+// the pool only changes where the scoring runs, never which move is chosen
+TEST(TetrisBot, PoolPicksTheSameMoves) {
+    ThreadPool pool(3);
+    Bot serial, parallel(&pool);
+    Field a, b;
+    srand(22);
+    int piece = rand() % PIECE_COUNT;
+    for (int i = 0; i < 300; i++) {
+        int next = rand() % PIECE_COUNT;
+        Placement x, y;
+        bool placed = serial.choose(a, piece, next, x);
+        ASSERT_EQ(placed, parallel.choose(b, piece, next, y));
+        if (!placed) break;
+        for (int c = 0; c < 4; c++) {
+            ASSERT_EQ(x.landed[c].x, y.landed[c].x);
+            ASSERT_EQ(x.landed[c].y, y.landed[c].y);
+        }
+        a.lock(x.landed, 1);
+        b.lock(y.landed, 1);
+        piece = next;
+    }
+}
+
+namespace {
+    // pieces the bot places before topping out, up to `pieces`
+    int botGame(bool lookahead, int pieces, int& lines) {
+        Bot bot;
+        Field field;
+        srand(3);
+        lines = 0;
+        int piece = rand() % PIECE_COUNT;
+        for (int i = 0; i < pieces; i++) {
+            int next = rand() % PIECE_COUNT;
+            Placement move;
+            if (!bot.choose(field, piece, lookahead ? next : -1, move)) return i;
+            lines += field.lock(move.landed, 1);
+            piece = next;
+        }
+        return pieces;
+    }
+}
+
+TEST(TetrisBot, ClearsLines) {
+    int lines;
+    EXPECT_GT(botGame(false, 300, lines), 250);
+    EXPECT_GT(lines, 90);
+}
+
+// the greedy bot sooner or later leaves a stack that the next piece can't
+// get past at the top; seeing that piece first keeps it going
+TEST(TetrisBot, LookaheadKeepsGoing) {
+    int greedyLines, lines;
+    EXPECT_GT(2000, botGame(false, 2000, greedyLines));
+    EXPECT_EQ(2000, botGame(true, 2000, lines));
+    EXPECT_GT(lines, greedyLines);
+}
+
+TEST(TetrisBag, DealsEveryPieceOncePerBag) {
+    Bag bag(5);
+    for (int round = 0; round < 100; round++) {
+        bool dealt[PIECE_COUNT] = {};
+        for (int i = 0; i < PIECE_COUNT; i++) {
+            int n = bag.next();
+            ASSERT_TRUE(n >= 0 && n < PIECE_COUNT);
+            EXPECT_FALSE(dealt[n]) << round;
+            dealt[n] = true;
+        }
+    }
+}
+
+// replays depend on these staying the same everywhere
+TEST(TetrisBag, SeedFixesTheOrder) {
+    Bag a(1), b(1), c(2);
+    std::vector<int> first, second, other;
+    for (int i = 0; i < 21; i++) {
+        first.push_back(a.next());
+        second.push_back(b.next());
+        other.push_back(c.next());
+    }
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+    EXPECT_EQ((std::vector<int>{ 5, 2, 3, 4, 1, 0, 6, 6, 2, 4, 3, 1, 5, 0, 1, 0, 2, 4, 5, 6, 3 }), first);
+}
+
+namespace {
+    const Input none = {};
+    Input keys(const char* held) {
+        Input input = {};
+        for (; *held; held++)
+            switch (*held) {
+            case 'L': input.left = true; break;
+            case 'R': input.right = true; break;
+            case 'X': input.rotateRight = true; break;
+            case 'Z': input.rotateLeft = true; break;
+            case 'D': input.softDrop = true; break;
+            case 'B': input.bot = true; break;
+            }
+        return input;
+    }
+
+    // a game of random key changes until it tops out, recorded
+    Replay randomGame(Game& game, uint32_t seed) {
+        game.reset(seed);
+        Recorder recorder(seed);
+        srand(seed);
+        Input input = {};
+        while (!game.gameOver) {
+            if (rand() % 8 == 0) input = unpackInput(rand() % 32);
+            recorder.record(input);
+            game.tick(input);
+        }
+        return recorder.finish(game);
+    }
+}
+
+TEST(TetrisGame, PiecesFallOnTheTickClock) {
+    Game game(3);
+    int y = game.piece.y;
+    for (int t = 1; t < game.fallTicks; t++) game.tick(none);
+    EXPECT_EQ(y, game.piece.y);
+    game.tick(none);
+    EXPECT_EQ(y + 1, game.piece.y);
+
+    for (int t = 0; t < 2 * game.softDropTicks; t++) game.tick(keys("D"));
+    EXPECT_EQ(y + 3, game.piece.y);
+}
+
+TEST(TetrisGame, HeldKeysActOnceBeforeTheRepeatDelay) {
+    Game game(3);
+    int x = game.piece.x;
+    for (int t = 0; t < game.dasTicks; t++) game.tick(keys("L"));
+    EXPECT_EQ(x - 1, game.piece.x);
+    game.tick(none);
+    game.tick(keys("L"));
+    EXPECT_EQ(x - 2, game.piece.x);
+
+    int rotation = game.piece.rotation;
+    for (int t = 0; t < 10; t++) game.tick(keys("X"));
+    EXPECT_EQ((rotation + 1) % 4, game.piece.rotation);
+    game.tick(keys("Z"));
+    EXPECT_EQ(rotation, game.piece.rotation);
+}
+
+TEST(TetrisGame, HeldSideKeysRepeat) {
+    Game game(3);
+    game.fallTicks = 1000;
+    int x = game.piece.x;
+
+    // one step on the press, one when the delay runs out, then one per repeat
+    game.tick(keys("R"));
+    EXPECT_EQ(x + 1, game.piece.x);
+    for (int t = 1; t < game.dasTicks; t++) game.tick(keys("R"));
+    EXPECT_EQ(x + 1, game.piece.x);
+    game.tick(keys("R"));
+    EXPECT_EQ(x + 2, game.piece.x);
+    for (int t = 0; t < game.arrTicks; t++) game.tick(keys("R"));
+    EXPECT_EQ(x + 3, game.piece.x);
+
+    // until the wall
+    for (int t = 0; t < 20 * game.arrTicks; t++) game.tick(keys("R"));
+    Piece further = game.piece;
+    further.x++;
+    EXPECT_FALSE(fits(game.field, further));
+
+    // pressing the other way takes over at once, and starts its own delay
+    int right = game.piece.x;
+    game.tick(keys("RL"));
+    EXPECT_EQ(right - 1, game.piece.x);
+    for (int t = 1; t < game.dasTicks; t++) game.tick(keys("RL"));
+    EXPECT_EQ(right - 1, game.piece.x);
+
+    // and letting go stops it
+    game.tick(none);
+    for (int t = 0; t < 3 * game.dasTicks; t++) game.tick(keys("D"));
+    EXPECT_EQ(right - 1, game.piece.x);
+}
+
+TEST(TetrisGame, ScoresClearedLines) {
+    // a game that starts with an I, over a bottom row with a gap it drops into
+    Game game(1);
+    for (uint32_t seed = 2; game.piece.type != I; seed++) game.reset(seed);
+    for (int x = 0; x < COLS; x++)
+        if (x < 3 || x > 6) block(game.field, Point{ x, ROWS - 1 });
+
+    while (game.lines == 0 && !game.gameOver) game.tick(none);
+    EXPECT_EQ(1, game.lines);
+    EXPECT_EQ(100, game.score);
+}
+
+TEST(TetrisGame, EndsWhenTheWellFills) {
+    Game game(9);
+    long long ticks = 0;
+    while (!game.gameOver && ticks < 100000) { game.tick(none); ticks++; }
+    ASSERT_TRUE(game.gameOver);
+
+    long long ended = game.ticks;
+    uint64_t sum = game.checksum();
+    game.tick(keys("LD"));
+    EXPECT_EQ(ended, game.ticks);
+    EXPECT_EQ(sum, game.checksum());
+}
+
+TEST(TetrisReplay, WritesAndReadsBack) {
+    Game game;
+    Replay replay = randomGame(game, 11);
+    ASSERT_GT(replay.changes.size(), 10u);
+
+    std::stringstream text;
+    writeReplay(text, replay);
+    Replay read;
+    ASSERT_TRUE(readReplay(text, read));
+
+    EXPECT_EQ(replay.seed, read.seed);
+    EXPECT_EQ(replay.bot, read.bot);
+    EXPECT_EQ(replay.ticks, read.ticks);
+    EXPECT_EQ(replay.score, read.score);
+    EXPECT_EQ(replay.lines, read.lines);
+    EXPECT_EQ(replay.checksum, read.checksum);
+    ASSERT_EQ(replay.changes.size(), read.changes.size());
+    for (size_t i = 0; i < replay.changes.size(); i++) {
+        EXPECT_EQ(replay.changes[i].tick, read.changes[i].tick);
+        EXPECT_EQ(replay.changes[i].keys, read.changes[i].keys);
+    }
+}
+
+TEST(TetrisReplay, RejectsWhatIsNotAReplay) {
+    Replay replay;
+    replay.seed = 77;
+    std::istringstream empty(""), other("spacing 1 2\n"), unfinished("tetris replay\nseed 3\n0 L\n"), bad("tetris replay\nseed 3\nx L\nend 1 0 0 0\n");
+    EXPECT_FALSE(readReplay(empty, replay));
+    EXPECT_FALSE(readReplay(other, replay));
+    EXPECT_FALSE(readReplay(unfinished, replay));
+    EXPECT_FALSE(readReplay(bad, replay));
+    EXPECT_EQ(77u, replay.seed);
+}
+
+TEST(TetrisReplay, PlaybackEndsLikeTheGame) {
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        Game game;
+        Replay replay = randomGame(game, seed);
+        Game again;
+        EXPECT_TRUE(playReplay(replay, again)) << seed;
+        EXPECT_EQ(game.checksum(), again.checksum()) << seed;
+
+        // the same pieces with every left and right press swapped are a different game
+        for (auto& c : replay.changes) c.keys = (c.keys & ~3u) | (c.keys & 1) << 1 | (c.keys & 2) >> 1;
+        EXPECT_FALSE(playReplay(replay, again)) << seed;
+    }
+}
+
+TEST(TetrisReplay, BotGamesReplayWithOrWithoutThePool) {
+    ThreadPool pool(3);
+    Game game(4, &pool);
+    Recorder recorder(4);
+    for (int t = 0; t < 3000; t++) {
+        Input input = t == 10 ? keys("B") : none; // the bot takes over after ten ticks
+        recorder.record(input);
+        game.tick(input);
+    }
+    ASSERT_GT(game.lines, 10);
+    Replay replay = recorder.finish(game);
+
+    Game serial;
+    EXPECT_TRUE(playReplay(replay, serial));
+    EXPECT_EQ(game.score, serial.score);
+}
+
+namespace {
+    TickScheduler::Clock::time_point at(long long ms) {
+        return TickScheduler::Clock::time_point() + std::chrono::milliseconds(ms);
+    }
+}
+
+TEST(TickScheduler, HandsOutWholeTicks) {
+    TickScheduler scheduler(50); // 20 ms ticks
+    scheduler.start(at(1000));
+
+    EXPECT_EQ(0, scheduler.due(at(1000)));
+    EXPECT_EQ(0, scheduler.due(at(1019)));
+    EXPECT_EQ(1, scheduler.due(at(1020)));
+    EXPECT_EQ(0, scheduler.due(at(1020)));
+    EXPECT_TRUE(at(1040) == scheduler.nextTick());
+    EXPECT_EQ(2, scheduler.due(at(1065)));
+    EXPECT_TRUE(at(1080) == scheduler.nextTick());
+}
+
+TEST(TickScheduler, DoesNotDrift) {
+    TickScheduler scheduler(60);
+    scheduler.start(at(0));
+    long long ticks = 0;
+    for (long long ms = 1; ms <= 60000; ms += 7) ticks += scheduler.due(at(ms));
+    EXPECT_EQ(60 * 60000 / 1000, ticks + scheduler.due(at(60000)));
+}
+
+TEST(TickScheduler, DropsTicksAfterAStall) {
+    TickScheduler scheduler(50, 5);
+    scheduler.start(at(0));
+    EXPECT_EQ(5, scheduler.due(at(10000)));
+    EXPECT_EQ(0, scheduler.due(at(10000)));
+    EXPECT_TRUE(at(10020) == scheduler.nextTick());
+    EXPECT_EQ(1, scheduler.due(at(10020)));
+}
@@ -0,0 +1,110 @@
+#include "pch.h"
+
+#include <thread>
+#include <vector>
+#include "../16_SFML_Games/XonixGame.h"
+
+// a bot that turns clockwise every 40 ticks, starting a new board on game over
+void playBot(XonixGame& game, int ticks) {
+	for (int t = 0; t < ticks; t++) {
+		if (game.gameOver) game.reset();
+		int turn = (t / 40) % 4;
+		XonixInput input = { turn == 3, turn == 1, turn == 0, turn == 2 };
+		game.tick(input);
+	}
+}
+
+TEST(XonixGame, StartsLikeTheClassicGame) {
+
+	XonixGame game;
+
+	EXPECT_EQ(25, game.grid.height());
+	EXPECT_EQ(40, game.grid.width());
+	EXPECT_EQ(4u, game.enemies.size());
+	EXPECT_EQ(300, game.enemies[0].x);
+	EXPECT_EQ(300, game.enemies[0].y);
+	EXPECT_EQ(10, game.player.x);
+	EXPECT_EQ(0, game.player.y);
+	EXPECT_FALSE(game.gameOver);
+}
+
+TEST(XonixGame, PlayerKeepsToItsOwnBoard) {
+
+	XonixGame game(1, 1, 10, 12, 18);
+	game.enemies[0].dx = game.enemies[0].dy = 0;
+	XonixInput right = { false, true, false, false };
+
+	for (int t = 0; t < 200; t++)
+		game.tick(right);
+
+	EXPECT_EQ(11, game.player.x);
+}
+
+TEST(XonixGame, PlayerDrawsWallAndCaptures) {
+
+	XonixGame game(1);
+	game.enemies[0].dx = game.enemies[0].dy = 0;
+	XonixInput down = { false, false, false, true };
+
+	for (int t = 0; t < 4 * 24; t++)
+		game.tick(down);
+
+	// the column under the player and everything left of it, away from the enemy
+	EXPECT_EQ(24, game.player.y);
+	EXPECT_FLOAT_EQ(100.f * 10 / 38, game.grid.capturedPercent());
+	EXPECT_EQ(0, game.levelsCompleted);
+	EXPECT_FALSE(game.gameOver);
+}
+
+TEST(XonixGame, CapturingEnoughStartsTheNextLevel) {
+
+	XonixGame game(1);
+	game.enemies[0].dx = game.enemies[0].dy = 0;
+	game.targetPercent = 20;
+	XonixInput down = { false, false, false, true };
+
+	for (int t = 0; t < 4 * 24; t++)
+		game.tick(down);
+
+	EXPECT_EQ(1, game.levelsCompleted);
+	EXPECT_EQ(0.f, game.grid.capturedPercent());
+	EXPECT_EQ(0, game.player.y);
+}
+
+TEST(XonixGame, SameSeedSameGame) {
+
+	XonixGame a(8, 42), b(8, 42), c(8, 43);
+
+	playBot(a, 3000);
+	playBot(b, 3000);
+	playBot(c, 3000);
+
+	EXPECT_EQ(a.checksum(), b.checksum());
+	EXPECT_NE(a.checksum(), c.checksum());
+}
+
+// many games at once on separate threads end up exactly where the same
+// games run one after another do, so nothing is shared between them
+TEST(XonixGame, GamesRunIndependentlyOnThreads) {
+
+	const int games = 16, ticks = 5000;
+
+	std::vector<uint64_t> expected;
+	for (int i = 0; i < games; i++) {
+		XonixGame game(4 + i, 100 + i);
+		playBot(game, ticks);
+		expected.push_back(game.checksum());
+	}
+
+	std::vector<uint64_t> results(games);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < games; i++)
+		threads.push_back(std::thread([i, &results] {
+			XonixGame game(4 + i, 100 + i);
+			playBot(game, ticks);
+			results[i] = game.checksum();
+		}));
+	for (auto& t : threads) t.join();
+
+	EXPECT_EQ(expected, results);
+}